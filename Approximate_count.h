@@ -0,0 +1,425 @@
+#ifndef APPROXIMATE_COUNT_H
+#define APPROXIMATE_COUNT_H
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "Bitset.h"
+#include "Graph_generators.h"
+#include "Subgraph_search.h"
+#include "Thread_pool.h"
+
+using namespace std;
+
+// Приближённый подсчёт сопоставлений, когда точный перебор слишком долог.
+// Оценка — среднее независимых несмещённых выборок, интервал — по нормальному
+// приближению с выборочной дисперсией
+enum class EstimateMethod {
+    Auto,           // раскраска для деревьев при мономорфизме, иначе спуски
+    ColourCoding,   // случайная раскраска в k цветов и динамика по дереву-паттерну (Алон — Юстер — Цвик)
+    Sampling        // случайные спуски по дереву поиска (оценка Кнута); любые паттерны и режимы
+};
+
+struct EstimateOptions {
+    EstimateMethod method = EstimateMethod::Auto;
+    MatchSemantics semantics = MatchSemantics::Induced;
+    chrono::steady_clock::duration timeLimit = chrono::seconds(1);     // 0 — без срока
+    uint64_t maxSamples = 0;        // раскрасок или спусков; 0 — без ограничения
+    double confidence = 0.95;
+    uint64_t seed = 1;
+    int threads = 1;                // 0 — по числу ядер
+};
+
+struct MatchEstimate {
+    double mappings = 0;            // оценка числа сопоставлений
+    double lower = 0;               // доверительный интервал уровня confidence
+    double upper = 0;
+    double relativeError = 0;       // полуширина интервала / оценка
+    uint64_t samples = 0;
+    EstimateMethod method = EstimateMethod::Sampling;
+    double seconds = 0;
+};
+
+// Раскраска применима к деревьям до такого размера: таблицы — по наборам цветов
+const int MAX_COLOUR_CODING_SIZE = 12;
+
+// Последовательность выборки i зависит только от зерна и i, поэтому при лимите
+// выборок результат не зависит от числа потоков
+struct SampleRandom {
+    uint64_t state;
+
+    explicit SampleRandom(uint64_t seed) : state(mixSeed(seed)) {}
+    uint64_t next() { return mixSeed(state += 0x9e3779b97f4a7c15ull); }
+    size_t below(size_t bound) { return (size_t)(next() % bound); }
+};
+
+template <typename Pattern>
+bool isTreePattern(const Pattern& pattern) {
+    int k = pattern.getVertexCount();
+    int64_t degrees = 0;
+    for (int u = 0; u < k; ++u) degrees += pattern.getDegree(u);
+    if (k < 2 || degrees != 2 * (int64_t)(k - 1)) return false;
+    vector<char> seen(k, 0);
+    vector<int> queue(1, 0);
+    seen[0] = 1;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        for (int w : pattern.getNeighbors(queue[head])) {
+            if (!seen[w]) {
+                seen[w] = 1;
+                queue.push_back(w);
+            }
+        }
+    }
+    return (int)queue.size() == k;
+}
+
+// Раскраска вершин графа в k цветов. Дерево-паттерн делится рёбром на две поддеревья с
+// корнями (активное — с корнем исходного, пассивное — с его соседом), и так до вершин;
+// таблица части — число разноцветных вложений части с корнем в v по каждому набору цветов.
+// Вложение всего паттерна разноцветно с вероятностью k!/k^k, так что число разноцветных,
+// умноженное на k^k/k!, — несмещённая оценка числа мономорфизмов
+template <typename Target, typename Pattern>
+class ColourCodingCounter {
+private:
+    struct Part {
+        int root;
+        int size;
+        int active = -1;
+        int passive = -1;
+        int edgeLabel = 0;      // метка ребра между корнями активной и пассивной частей
+    };
+
+    const Target* target;
+    const Pattern* pattern;
+    int k;
+    int n;
+    double scale;                       // k^k / k!
+    vector<Part> parts;                 // части идут раньше составленных из них
+    vector<vector<uint32_t>> bySize;    // наборы цветов каждого размера
+    vector<int> rank;                   // номер набора среди наборов своего размера
+    vector<uint8_t> colour;
+    vector<vector<double>> tables;      // tables[часть][v * число наборов + номер набора]
+    vector<double> around;              // суммы таблицы пассивной части по соседям
+
+    int split(int root, uint32_t vertices);
+
+public:
+    ColourCodingCounter(const Target& targetGraph, const Pattern& patternGraph);
+    double sample(uint64_t seed);
+};
+
+template <typename Target, typename Pattern>
+ColourCodingCounter<Target, Pattern>::ColourCodingCounter(const Target& targetGraph, const Pattern& patternGraph)
+    : target(&targetGraph), pattern(&patternGraph), k(patternGraph.getVertexCount()),
+      n(targetGraph.getVertexCount()), scale(1), bySize(k + 1), rank(1u << k), colour(n) {
+    for (int i = 1; i <= k; ++i) scale *= (double)k / i;
+    for (uint32_t mask = 0; mask < (1u << k); ++mask) {
+        vector<uint32_t>& sized = bySize[bitCountWord(mask)];
+        rank[mask] = (int)sized.size();
+        sized.push_back(mask);
+    }
+    int root = 0;
+    for (int u = 1; u < k; ++u) {
+        if (pattern->getDegree(u) > pattern->getDegree(root)) root = u;
+    }
+    split(root, (1u << k) - 1);
+    tables.resize(parts.size());
+}
+
+// Пассивной становится наименьшая из ветвей корня: её таблица суммируется по всем рёбрам графа
+template <typename Target, typename Pattern>
+int ColourCodingCounter<Target, Pattern>::split(int root, uint32_t vertices) {
+    Part part;
+    part.root = root;
+    part.size = bitCountWord(vertices);
+    if (part.size > 1) {
+        uint32_t smallest = 0;
+        int child = -1;
+        for (int c : pattern->getNeighbors(root)) {
+            if (!(vertices >> c & 1)) continue;
+            uint32_t branch = 1u << c;
+            vector<int> queue(1, c);
+            for (size_t head = 0; head < queue.size(); ++head) {
+                for (int w : pattern->getNeighbors(queue[head])) {
+                    if (w != root && (vertices >> w & 1) && !(branch >> w & 1)) {
+                        branch |= 1u << w;
+                        queue.push_back(w);
+                    }
+                }
+            }
+            if (child < 0 || bitCountWord(branch) < bitCountWord(smallest)) {
+                smallest = branch;
+                child = c;
+            }
+        }
+        part.active = split(root, vertices & ~smallest);
+        part.passive = split(child, smallest);
+        part.edgeLabel = pattern->getEdgeLabel(root, child);
+    }
+    parts.push_back(part);
+    return (int)parts.size() - 1;
+}
+
+template <typename Target, typename Pattern>
+double ColourCodingCounter<Target, Pattern>::sample(uint64_t seed) {
+    SampleRandom random(seed);
+    for (int v = 0; v < n; ++v) colour[v] = (uint8_t)random.below(k);
+    bool edgeLabelled = target->hasEdgeLabels() || pattern->hasEdgeLabels();
+
+    for (size_t p = 0; p < parts.size(); ++p) {
+        const Part& part = parts[p];
+        size_t width = bySize[part.size].size();
+        vector<double>& table = tables[p];
+        table.assign((size_t)n * width, 0);
+        if (part.size == 1) {
+            int u = part.root;
+            for (int v = 0; v < n; ++v) {
+                if (target->getVertexLabel(v) == pattern->getVertexLabel(u) &&
+                    target->getDegree(v) >= pattern->getDegree(u)) {
+                    table[(size_t)v * width + rank[1u << colour[v]]] = 1;
+                }
+            }
+            continue;
+        }
+
+        const Part& active = parts[part.active];
+        const Part& passive = parts[part.passive];
+        size_t activeWidth = bySize[active.size].size();
+        size_t passiveWidth = bySize[passive.size].size();
+        const vector<double>& activeTable = tables[part.active];
+        const vector<double>& passiveTable = tables[part.passive];
+
+        around.assign((size_t)n * passiveWidth, 0);
+        for (int v = 0; v < n; ++v) {
+            double* sum = around.data() + (size_t)v * passiveWidth;
+            for (int w : target->getNeighbors(v)) {
+                if (edgeLabelled && target->getEdgeLabel(v, w) != part.edgeLabel) continue;
+                const double* row = passiveTable.data() + (size_t)w * passiveWidth;
+                for (size_t i = 0; i < passiveWidth; ++i) sum[i] += row[i];
+            }
+        }
+
+        // Набор S делится на набор активной части и остаток — набор пассивной
+        for (int v = 0; v < n; ++v) {
+            const double* activeRow = activeTable.data() + (size_t)v * activeWidth;
+            bool any = false;
+            for (size_t i = 0; i < activeWidth && !any; ++i) any = activeRow[i] != 0;
+            if (!any) continue;
+            const double* passiveSum = around.data() + (size_t)v * passiveWidth;
+            double* row = table.data() + (size_t)v * width;
+            for (size_t j = 0; j < width; ++j) {
+                uint32_t colours = bySize[part.size][j];
+                double total = 0;
+                for (uint32_t sub = colours; sub != 0; sub = (sub - 1) & colours) {
+                    if (bitCountWord(sub) != active.size) continue;
+                    double count = activeRow[rank[sub]];
+                    if (count != 0) total += count * passiveSum[rank[colours ^ sub]];
+                }
+                row[j] = total;
+            }
+        }
+        vector<double>().swap(tables[part.active]);
+        vector<double>().swap(tables[part.passive]);
+    }
+
+    double colourful = 0;
+    for (double count : tables.back()) colourful += count;
+    return colourful * scale;
+}
+
+// Оценка Кнута размера дерева поиска, обрезанного до листьев-сопоставлений: спуск по
+// порядку плана, на каждом уровне образ выбирается равновероятно из c допустимых,
+// вес спуска — произведение c, ноль при тупике. Математическое ожидание веса равно числу
+// сопоставлений. Допустимость проверяется полностью (метки, рёбра и при индуцированном
+// поиске неребра к уже сопоставленным, степень, занятость), так что тупиков меньше
+template <typename Target, typename Pattern>
+class SearchTreeSampler {
+private:
+    const Target* target;
+    const Pattern* pattern;
+    MatchPlan plan;
+    bool injective;
+    bool induced;
+    bool edgeLabelled;
+    vector<vector<int>> nonBack;    // несмежные с order[depth] вершины паттерна раньше в порядке
+    vector<int> roots;              // допустимые образы order[0]
+    vector<int> mapping;
+    vector<char> used;
+    vector<int> candidates;
+
+    bool fits(int depth, int v) const;
+
+public:
+    SearchTreeSampler(const Target& targetGraph, const Pattern& patternGraph, MatchSemantics semantics);
+    double sample(uint64_t seed);
+};
+
+template <typename Target, typename Pattern>
+SearchTreeSampler<Target, Pattern>::SearchTreeSampler(const Target& targetGraph, const Pattern& patternGraph,
+                                                      MatchSemantics semantics)
+    : target(&targetGraph), pattern(&patternGraph), plan(buildMatchPlan(targetGraph, patternGraph)),
+      injective(semantics != MatchSemantics::Homomorphism), induced(semantics == MatchSemantics::Induced),
+      edgeLabelled(targetGraph.hasEdgeLabels() || patternGraph.hasEdgeLabels()),
+      mapping(patternGraph.getVertexCount(), -1), used(injective ? targetGraph.getVertexCount() : 0, 0) {
+    int k = pattern->getVertexCount();
+    nonBack.resize(k);
+    for (int depth = 0; depth < k && induced; ++depth) {
+        for (int earlier = 0; earlier < depth; ++earlier) {
+            int w = plan.order[earlier];
+            if (!pattern->hasEdge(plan.order[depth], w)) nonBack[depth].push_back(w);
+        }
+    }
+    for (int v = 0; v < target->getVertexCount() && k > 0; ++v) {
+        if (fits(0, v)) roots.push_back(v);
+    }
+}
+
+template <typename Target, typename Pattern>
+bool SearchTreeSampler<Target, Pattern>::fits(int depth, int v) const {
+    int u = plan.order[depth];
+    if (target->getVertexLabel(v) != pattern->getVertexLabel(u)) return false;
+    if (injective && (used[v] || target->getDegree(v) < pattern->getDegree(u))) return false;
+    for (int w : plan.backNeighbors[depth]) {
+        if (!target->hasEdge(v, mapping[w])) return false;
+        if (edgeLabelled && target->getEdgeLabel(v, mapping[w]) != pattern->getEdgeLabel(u, w)) return false;
+    }
+    for (int w : nonBack[depth]) {
+        if (target->hasEdge(v, mapping[w])) return false;
+    }
+    return true;
+}
+
+template <typename Target, typename Pattern>
+double SearchTreeSampler<Target, Pattern>::sample(uint64_t seed) {
+    SampleRandom random(seed);
+    int k = pattern->getVertexCount();
+    double weight = 1;
+    int depth = 0;
+    for (; depth < k; ++depth) {
+        const vector<int>* choices = &candidates;
+        candidates.clear();
+        const vector<int>& back = plan.backNeighbors[depth];
+        if (depth == 0) {
+            choices = &roots;
+        } else if (back.empty()) {
+            for (int v = 0; v < target->getVertexCount(); ++v) {
+                if (fits(depth, v)) candidates.push_back(v);
+            }
+        } else {
+            // Кандидаты — соседи образа смежной вершины с наименьшей степенью
+            int anchor = mapping[back[0]];
+            for (int w : back) {
+                if (target->getDegree(mapping[w]) < target->getDegree(anchor)) anchor = mapping[w];
+            }
+            for (int v : target->getNeighbors(anchor)) {
+                if (fits(depth, v)) candidates.push_back(v);
+            }
+        }
+        if (choices->empty()) {
+            weight = 0;
+            break;
+        }
+        weight *= (double)choices->size();
+        int v = (*choices)[random.below(choices->size())];
+        mapping[plan.order[depth]] = v;
+        if (injective) used[v] = 1;
+    }
+    for (int d = 0; d < depth && injective; ++d) used[mapping[plan.order[d]]] = 0;
+    return weight;
+}
+
+// Квантиль z двустороннего интервала: P(|Z| > z) = 1 - confidence
+inline double normalQuantile(double confidence) {
+    double low = 0, high = 40;
+    for (int i = 0; i < 100; ++i) {
+        double middle = (low + high) / 2;
+        if (erfc(middle / sqrt(2.0)) > 1 - confidence) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return (low + high) / 2;
+}
+
+// Выборки берутся до исчерпания срока или лимита (не меньше двух, чтобы была оценка
+// дисперсии); без обоих ограничений — 1000 выборок. Каждый поток держит свой счётчик,
+// для раскраски — свои таблицы: O(V * C(k, k/2)) чисел на поток
+template <typename Target, typename Pattern>
+MatchEstimate estimateMatches(const Target& target, const Pattern& pattern,
+                              const EstimateOptions& options = EstimateOptions()) {
+    auto started = chrono::steady_clock::now();
+    MatchEstimate result;
+    bool colourable = options.semantics == MatchSemantics::Monomorphism &&
+                      pattern.getVertexCount() <= MAX_COLOUR_CODING_SIZE && isTreePattern(pattern);
+    result.method = options.method != EstimateMethod::Sampling && colourable ? EstimateMethod::ColourCoding
+                                                                           : EstimateMethod::Sampling;
+    uint64_t quota = options.maxSamples;
+    bool timed = options.timeLimit > chrono::steady_clock::duration::zero();
+    if (quota == 0 && !timed) quota = 1000;
+    auto deadline = started + options.timeLimit;
+    int threads = options.threads > 0 ? options.threads : (int)max(1u, thread::hardware_concurrency());
+    if (quota != 0) threads = (int)min<uint64_t>(threads, quota);
+
+    struct alignas(64) Sums {
+        double sum = 0;
+        double squares = 0;
+        uint64_t count = 0;
+    };
+    vector<Sums> sums(threads);
+    atomic<uint64_t> nextSample(0);
+    auto work = [&](int worker) {
+        auto run = [&](auto& sampler) {
+            while (true) {
+                uint64_t i = nextSample++;
+                if (quota != 0 && i >= quota) break;
+                if (timed && i >= 2 && chrono::steady_clock::now() >= deadline) break;
+                double value = sampler.sample(options.seed ^ mixSeed(i + 1));
+                sums[worker].sum += value;
+                sums[worker].squares += value * value;
+                sums[worker].count++;
+            }
+        };
+        if (result.method == EstimateMethod::ColourCoding) {
+            ColourCodingCounter<Target, Pattern> counter(target, pattern);
+            run(counter);
+        } else {
+            SearchTreeSampler<Target, Pattern> sampler(target, pattern, options.semantics);
+            run(sampler);
+        }
+    };
+    if (threads == 1) {
+        work(0);
+    } else {
+        WorkStealingPool pool(threads);
+        for (int worker = 0; worker < threads; ++worker) {
+            pool.submit([&, worker](int) { work(worker); });
+        }
+        pool.wait();
+    }
+
+    double sum = 0, squares = 0;
+    for (const Sums& part : sums) {
+        sum += part.sum;
+        squares += part.squares;
+        result.samples += part.count;
+    }
+    double count = (double)result.samples;
+    result.mappings = sum / count;
+    if (result.samples > 1) {
+        double variance = max(0.0, (squares - count * result.mappings * result.mappings) / (count - 1));
+        double half = normalQuantile(options.confidence) * sqrt(variance / count);
+        result.lower = max(0.0, result.mappings - half);
+        result.upper = result.mappings + half;
+        result.relativeError = result.mappings > 0 ? half / result.mappings : 0;
+    } else {
+        result.upper = numeric_limits<double>::infinity();
+        result.relativeError = numeric_limits<double>::infinity();
+    }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    return result;
+}
+
+#endif
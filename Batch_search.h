@@ -0,0 +1,430 @@
+#ifndef BATCH_SEARCH_H
+#define BATCH_SEARCH_H
+
+#include "Subgraph_search.h"
+
+using namespace std;
+
+// Пакетный поиск: много небольших паттернов против одного графа. Характеристики
+// графа (степени, степени соседей, треугольники, индекс меток) считаются один раз
+// при создании BatchQuery. Паттерны с общим началом порядка сопоставления идут по
+// общей ветви префиксного дерева: вложения общего префикса перебираются один раз
+// для всех паттернов ветви, а паттерн выбывает, как только образ выпадает из его
+// домена или нарушает его ограничения симметрии.
+// Граф должен жить дольше BatchQuery. Если Graph изменился после создания, каждый
+// вызов заново считает характеристики для себя — для серии запросов к изменённому
+// графу стоит создать новый BatchQuery. SearchOptions::plan и automorphisms
+// относятся к одному паттерну и здесь не используются
+template <typename Target>
+class BatchQuery {
+public:
+    explicit BatchQuery(const Target& targetGraph)
+        : target(&targetGraph), index(buildTargetIndex(targetGraph)) {}
+
+    const TargetIndex& getIndex() const { return index; }
+
+    // visit(worker, pattern, mapping) — номер исполнителя, номер паттерна в patterns
+    // и сопоставление; false останавливает весь пакет. Возвращает false при остановке
+    template <typename Pattern, typename Visitor>
+    bool run(const vector<Pattern>& patterns, const SearchOptions& options, Visitor visit) const {
+        return runBatch(patterns, options, visit, true);
+    }
+
+    // Число сопоставлений для каждого паттерна
+    template <typename Pattern>
+    vector<uint64_t> count(const vector<Pattern>& patterns, const SearchOptions& options = SearchOptions()) const;
+
+    // Сопоставления для каждого паттерна, по возрастанию
+    template <typename Pattern>
+    vector<vector<vector<int>>> search(const vector<Pattern>& patterns,
+                                       const SearchOptions& options = SearchOptions()) const;
+
+private:
+    // Узел префиксного дерева: вершина позиции depth со своими рёбрами к предыдущим позициям
+    struct Node {
+        int depth = -1;
+        vector<int> back;           // позиции смежных с ней вершин префикса
+        vector<int> backLabels;     // метки этих рёбер
+        vector<int> nonBack;        // остальные позиции префикса
+        vector<int> children;
+        vector<int> patterns;       // паттерны, проходящие через узел
+        BitVector domain;           // объединение доменов этих паттернов на позиции depth
+    };
+
+    struct Prepared {
+        int size = 0;
+        bool feasible = true;
+        MatchPlan plan;
+        CandidateDomains domains;
+        PatternSymmetry symmetry;
+        bool expand = false;
+        vector<vector<int>> greater;    // позиции, образы которых меньше образа позиции depth
+        vector<vector<int>> less;       // позиции, образы которых больше
+        vector<int> nodes;              // узел дерева на каждой позиции
+    };
+
+    // Состояние исполнителя: образы позиций и списки живых паттернов по уровням
+    struct Worker {
+        vector<int> image;
+        vector<char> used;
+        vector<vector<int>> alive;
+        vector<vector<int>> childAlive;
+        vector<int> mapping;
+        SEARCH_STAT(SearchStats stats;)
+    };
+
+    const Target* target;
+    TargetIndex index;
+
+    template <typename Pattern, typename Visitor>
+    bool runBatch(const vector<Pattern>& patterns, const SearchOptions& options, Visitor& visit,
+                  bool expandSymmetryClasses) const;
+};
+
+template <typename Target>
+template <typename Pattern, typename Visitor>
+bool BatchQuery<Target>::runBatch(const vector<Pattern>& patterns, const SearchOptions& options, Visitor& visit,
+                                  bool expandSymmetryClasses) const {
+    if (options.control != nullptr) {
+        options.control->begin();
+    }
+    SEARCH_STAT(auto started = chrono::steady_clock::now());
+
+    int V = target->getVertexCount();
+    int rowWords = bitRowWords(V);
+    bool injective = options.semantics != MatchSemantics::Homomorphism;
+    bool induced = options.semantics == MatchSemantics::Induced;
+    bool breaking = breaksSymmetry(options);
+    bool edgeLabelled = target->hasEdgeLabels();
+    for (const Pattern& pattern : patterns) edgeLabelled = edgeLabelled || pattern.hasEdgeLabels();
+
+    // Граф изменился после создания: индекс устарел
+    TargetIndex rebuilt;
+    const TargetIndex* current = &index;
+    if (!index.matches(*target)) {
+        rebuilt = buildTargetIndex(*target);
+        current = &rebuilt;
+    }
+
+    WorkStealingPool pool(resolveThreads(options));
+
+    // Подготовка паттернов не зависит друг от друга и идёт на пуле
+    vector<Prepared> prepared(patterns.size());
+    for (size_t p = 0; p < patterns.size(); ++p) {
+        pool.submit([&, p](int) {
+            const Pattern& pattern = patterns[p];
+            Prepared& item = prepared[p];
+            item.size = pattern.getVertexCount();
+            if (injective && item.size > V) {
+                item.feasible = false;
+                return;
+            }
+            item.plan = buildMatchPlan(*target, pattern, current);
+            item.feasible = buildCandidateDomains(*target, pattern, options.semantics, item.domains, current);
+            if (!item.feasible || !breaking) return;
+
+            item.symmetry = buildPatternSymmetry(pattern, &item.plan.order);
+            item.expand = expandSymmetryClasses && options.symmetry == SymmetryMode::Expand &&
+                          !item.symmetry.base.empty();
+            SymmetryBounds bounds = buildSymmetryBounds(item.plan, item.symmetry);
+            item.greater.resize(item.size);
+            item.less.resize(item.size);
+            for (int d = 0; d < item.size; ++d) {
+                for (int w : bounds.greater[d]) item.greater[d].push_back(item.plan.position[w]);
+                for (int w : bounds.less[d]) item.less[d].push_back(item.plan.position[w]);
+            }
+        });
+    }
+    pool.wait();
+
+    // Префиксное дерево по порядкам сопоставления
+    vector<Node> nodes(1);
+    int maxSize = 0;
+    for (size_t p = 0; p < patterns.size(); ++p) {
+        Prepared& item = prepared[p];
+        if (!item.feasible || item.size == 0) continue;
+        maxSize = max(maxSize, item.size);
+        int current = 0;
+        for (int d = 0; d < item.size; ++d) {
+            int u = item.plan.order[d];
+            vector<int> back, labels;
+            for (int w : item.plan.backNeighbors[d]) back.push_back(item.plan.position[w]);
+            sort(back.begin(), back.end());
+            for (int position : back) {
+                labels.push_back(patterns[p].getEdgeLabel(u, item.plan.order[position]));
+            }
+
+            int next = -1;
+            for (int child : nodes[current].children) {
+                if (nodes[child].back == back && nodes[child].backLabels == labels) {
+                    next = child;
+                    break;
+                }
+            }
+            if (next == -1) {
+                Node node;
+                node.depth = d;
+                node.back = back;
+                node.backLabels = labels;
+                for (int position = 0; position < d; ++position) {
+                    if (!binary_search(back.begin(), back.end(), position)) node.nonBack.push_back(position);
+                }
+                node.domain.assign(rowWords, 0);
+                next = (int)nodes.size();
+                nodes[current].children.push_back(next);
+                nodes.push_back(move(node));
+            }
+
+            Node& node = nodes[next];
+            node.patterns.push_back((int)p);
+            const uint64_t* row = item.domains.row(u);
+            for (int w = 0; w < rowWords; ++w) node.domain[w] |= row[w];
+            item.nodes.push_back(next);
+            current = next;
+        }
+    }
+
+#ifdef SUBGRAPH_SEARCH_STATS
+    if (options.stats != nullptr) {
+        for (const Prepared& item : prepared) options.stats->merge(item.domains.stats);
+        options.stats->preprocessSeconds += secondsSince(started);
+    }
+    auto searchStarted = chrono::steady_clock::now();
+#endif
+
+    vector<Worker> workers(pool.size());
+    for (Worker& worker : workers) {
+        worker.image.assign(maxSize, -1);
+        worker.used.assign(V, 0);
+        worker.alive.resize(maxSize);
+        worker.childAlive.resize(maxSize);
+    }
+    atomic<bool> stopped(false);
+
+    // Пустой паттерн вкладывается ровно одним способом
+    for (size_t p = 0; p < patterns.size() && !stopped; ++p) {
+        if (prepared[p].feasible && prepared[p].size == 0 && !visit(0, (int)p, vector<int>())) {
+            stopped = true;
+        }
+    }
+
+    auto deliver = [&](int worker, int p, const vector<int>& mapping) {
+        const Prepared& item = prepared[p];
+        if (!item.expand) return visit(worker, p, mapping);
+        vector<vector<int>> current(item.symmetry.base.size() + 1);
+        current[0] = mapping;
+        auto emit = [&](const vector<int>& expanded) { return visit(worker, p, expanded); };
+        return expandSymmetry(item.symmetry, 0, current, emit);
+    };
+
+    // extend — кандидат v на позицию depth узла node; explore — все кандидаты узла
+    function<bool(int, int, const vector<int>&, ControlProbe&)> explore;
+    auto extend = [&](int worker, int nodeIndex, int v, const vector<int>& alive, ControlProbe& probe) {
+        if (stopped || !probe.tick()) return false;
+        const Node& node = nodes[nodeIndex];
+        Worker& state = workers[worker];
+        int depth = node.depth;
+        SEARCH_STAT(state.stats.candidatesTried++);
+
+        if (!bitTest(node.domain.data(), v)) {
+            SEARCH_STAT(state.stats.prunedDomain++);
+            return true;
+        }
+        if (injective && state.used[v]) {
+            SEARCH_STAT(state.stats.prunedInjectivity++);
+            return true;
+        }
+        for (size_t i = 0; i < node.back.size(); ++i) {
+            int w = state.image[node.back[i]];
+            if (!target->hasEdge(v, w)) {
+                SEARCH_STAT(state.stats.prunedAdjacency++);
+                return true;
+            }
+            if (edgeLabelled && target->getEdgeLabel(v, w) != node.backLabels[i]) {
+                SEARCH_STAT(state.stats.prunedEdgeLabel++);
+                return true;
+            }
+        }
+        if (induced) {
+            for (int position : node.nonBack) {
+                if (target->hasEdge(v, state.image[position])) {
+                    SEARCH_STAT(state.stats.prunedAdjacency++);
+                    return true;
+                }
+            }
+        }
+
+        // Паттерны ветви, для которых v допустим
+        vector<int>& next = state.alive[depth];
+        next.clear();
+        for (int p : alive) {
+            const Prepared& item = prepared[p];
+            if (!bitTest(item.domains.row(item.plan.order[depth]), v)) continue;
+            bool fits = true;
+            if (breaking) {
+                for (int position : item.greater[depth]) fits = fits && v > state.image[position];
+                for (int position : item.less[depth]) fits = fits && v < state.image[position];
+            }
+            if (fits) next.push_back(p);
+        }
+        if (next.empty()) {
+            SEARCH_STAT(state.stats.prunedSymmetry++);
+            return true;
+        }
+
+        state.image[depth] = v;
+        if (injective) state.used[v] = 1;
+        bool proceed = true;
+        for (int p : next) {
+            const Prepared& item = prepared[p];
+            if (item.size != depth + 1) continue;
+            SEARCH_STAT(state.stats.matches++);
+            state.mapping.resize(item.size);
+            for (int d = 0; d < item.size; ++d) state.mapping[item.plan.order[d]] = state.image[d];
+            if (!deliver(worker, p, state.mapping)) {
+                proceed = false;
+                break;
+            }
+        }
+        for (size_t c = 0; proceed && c < node.children.size(); ++c) {
+            int child = node.children[c];
+            vector<int>& childAlive = state.childAlive[depth];
+            childAlive.clear();
+            for (int p : next) {
+                if (prepared[p].size > depth + 1 && prepared[p].nodes[depth + 1] == child) childAlive.push_back(p);
+            }
+            if (!childAlive.empty()) proceed = explore(worker, child, childAlive, probe);
+        }
+        if (injective) state.used[v] = 0;
+        if (!proceed) stopped = true;
+        return proceed;
+    };
+
+    explore = [&](int worker, int nodeIndex, const vector<int>& alive, ControlProbe& probe) {
+        const Node& node = nodes[nodeIndex];
+        Worker& state = workers[worker];
+        SEARCH_STAT(state.stats.enter(node.depth));
+        if (node.back.empty()) {
+            for (int w = 0; w < rowWords; ++w) {
+                uint64_t bits = node.domain[w];
+                while (bits) {
+                    int v = w * BIT_WORD_BITS + bitLowestWord(bits);
+                    bits &= bits - 1;
+                    if (!extend(worker, nodeIndex, v, alive, probe)) return false;
+                }
+            }
+            return true;
+        }
+        // Кандидаты — соседи образа смежной позиции с наименьшей степенью
+        int anchor = state.image[node.back[0]];
+        for (int position : node.back) {
+            if (target->getDegree(state.image[position]) < target->getDegree(anchor)) anchor = state.image[position];
+        }
+        for (int v : target->getNeighbors(anchor)) {
+            if (!extend(worker, nodeIndex, v, alive, probe)) return false;
+        }
+        return true;
+    };
+
+    // Задачи: корневые ветви дерева, кандидаты первой позиции режутся на куски по словам
+    int chunkWords = max(1, rowWords / (pool.size() * 4));
+    vector<tuple<int, int, int>> tasks;
+    for (int child : nodes[0].children) {
+        for (int from = 0; from < rowWords; from += chunkWords) {
+            tasks.emplace_back(child, from, min(rowWords, from + chunkWords));
+        }
+    }
+    double taskWeight = tasks.empty() ? 0 : 1.0 / tasks.size();
+    for (const auto& task : tasks) {
+        pool.submit([&, task](int worker) {
+            int child = get<0>(task);
+            const Node& node = nodes[child];
+            ControlProbe probe;
+            probe.control = options.control;
+            probe.weight = taskWeight;
+            if (probe.control != nullptr) {
+                probe.branches = bitsCount(node.domain.data() + get<1>(task), get<2>(task) - get<1>(task));
+                if (probe.branches == 0) probe.control->addProgress(taskWeight);
+            }
+            if (stopped) return;
+            SEARCH_STAT(workers[worker].stats.enter(0));
+            for (int w = get<1>(task); w < get<2>(task); ++w) {
+                uint64_t bits = node.domain[w];
+                while (bits) {
+                    int v = w * BIT_WORD_BITS + bitLowestWord(bits);
+                    bits &= bits - 1;
+                    if (!extend(worker, child, v, node.patterns, probe)) {
+                        stopped = true;
+                        return;
+                    }
+                    probe.branchDone(0);
+                }
+            }
+            if (!probe.flush()) stopped = true;
+        });
+    }
+    pool.wait();
+
+    if (options.control != nullptr) {
+        options.control->finish();
+    }
+#ifdef SUBGRAPH_SEARCH_STATS
+    if (options.stats != nullptr) {
+        for (const Worker& worker : workers) options.stats->merge(worker.stats);
+        options.stats->searchSeconds += secondsSince(searchStarted);
+    }
+#endif
+    return !stopped;
+}
+
+template <typename Target>
+template <typename Pattern>
+vector<uint64_t> BatchQuery<Target>::count(const vector<Pattern>& patterns, const SearchOptions& options) const {
+    // Счётчики исполнителя подряд, чтобы исполнители не делили кэш-линии
+    size_t stride = (patterns.size() + 7) / 8 * 8;
+    vector<uint64_t> counters(resolveThreads(options) * stride, 0);
+    auto countVisit = [&](int worker, int p, const vector<int>&) {
+        counters[worker * stride + p]++;
+        return true;
+    };
+    // Классы при Expand не раскрываются: каждый содержит ровно |Aut(P)| сопоставлений
+    runBatch(patterns, options, countVisit, false);
+
+    vector<uint64_t> totals(patterns.size(), 0);
+    for (size_t worker = 0; worker * stride < counters.size(); ++worker) {
+        for (size_t p = 0; p < patterns.size(); ++p) totals[p] += counters[worker * stride + p];
+    }
+    if (options.symmetry == SymmetryMode::Expand && breaksSymmetry(options)) {
+        for (size_t p = 0; p < patterns.size(); ++p) {
+            if (patterns[p].getVertexCount() > 0 && totals[p] > 0) {
+                totals[p] *= buildPatternSymmetry(patterns[p]).automorphisms;
+            }
+        }
+    }
+    return totals;
+}
+
+template <typename Target>
+template <typename Pattern>
+vector<vector<vector<int>>> BatchQuery<Target>::search(const vector<Pattern>& patterns,
+                                                       const SearchOptions& options) const {
+    int threads = resolveThreads(options);
+    vector<vector<vector<vector<int>>>> results(threads, vector<vector<vector<int>>>(patterns.size()));
+    auto collect = [&](int worker, int p, const vector<int>& mapping) {
+        results[worker][p].push_back(mapping);
+        return true;
+    };
+    run(patterns, options, collect);
+
+    vector<vector<vector<int>>> merged = move(results[0]);
+    for (int worker = 1; worker < threads; ++worker) {
+        for (size_t p = 0; p < patterns.size(); ++p) {
+            merged[p].insert(merged[p].end(), make_move_iterator(results[worker][p].begin()),
+                             make_move_iterator(results[worker][p].end()));
+        }
+    }
+    for (auto& mappings : merged) sort(mappings.begin(), mappings.end());
+    return merged;
+}
+
+#endif
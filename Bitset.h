@@ -0,0 +1,187 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+// Строки битовых множеств выравниваются по кэш-линии (64 байта = 8 слов),
+// поэтому длина строки в словах всегда кратна 8
+const int BIT_WORD_BITS = 64;
+const int BIT_ROW_ALIGN_WORDS = 8;
+
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), align_val_t(64)));
+    }
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, align_val_t(64));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+using BitVector = vector<uint64_t, AlignedAllocator<uint64_t>>;
+
+// Число слов для строки из bits бит (с выравниванием)
+inline int bitRowWords(int bits) {
+    int words = (bits + BIT_WORD_BITS - 1) / BIT_WORD_BITS;
+    return (words + BIT_ROW_ALIGN_WORDS - 1) / BIT_ROW_ALIGN_WORDS * BIT_ROW_ALIGN_WORDS;
+}
+
+inline bool bitTest(const uint64_t* bits, int i) {
+    return (bits[i >> 6] >> (i & 63)) & 1;
+}
+
+inline void bitSet(uint64_t* bits, int i) {
+    bits[i >> 6] |= uint64_t(1) << (i & 63);
+}
+
+inline void bitClear(uint64_t* bits, int i) {
+    bits[i >> 6] &= ~(uint64_t(1) << (i & 63));
+}
+
+inline int bitCountWord(uint64_t w) {
+#ifdef _MSC_VER
+    return (int)__popcnt64(w);
+#else
+    return __builtin_popcountll(w);
+#endif
+}
+
+inline int bitLowestWord(uint64_t w) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, w);
+    return (int)index;
+#else
+    return __builtin_ctzll(w);
+#endif
+}
+
+// Первые bits бит равны единице, остальные слова строки нулевые
+inline void bitsFillPrefix(uint64_t* dst, int bits, int words) {
+    for (int i = 0; i < words; ++i) {
+        int from = i * BIT_WORD_BITS;
+        if (bits >= from + BIT_WORD_BITS) {
+            dst[i] = ~uint64_t(0);
+        } else if (bits > from) {
+            dst[i] = (uint64_t(1) << (bits - from)) - 1;
+        } else {
+            dst[i] = 0;
+        }
+    }
+}
+
+// dst = a & b; возвращает true, если результат не пуст
+inline bool bitsAnd(uint64_t* dst, const uint64_t* a, const uint64_t* b, int words) {
+#if defined(__AVX512F__)
+    __m512i acc = _mm512_setzero_si512();
+    for (int i = 0; i < words; i += 8) {
+        __m512i x = _mm512_load_si512((const void*)(a + i));
+        __m512i y = _mm512_load_si512((const void*)(b + i));
+        __m512i r = _mm512_and_si512(x, y);
+        _mm512_store_si512((void*)(dst + i), r);
+        acc = _mm512_or_si512(acc, r);
+    }
+    return _mm512_test_epi64_mask(acc, acc) != 0;
+#elif defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (int i = 0; i < words; i += 4) {
+        __m256i x = _mm256_load_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_load_si256((const __m256i*)(b + i));
+        __m256i r = _mm256_and_si256(x, y);
+        _mm256_store_si256((__m256i*)(dst + i), r);
+        acc = _mm256_or_si256(acc, r);
+    }
+    return !_mm256_testz_si256(acc, acc);
+#else
+    uint64_t acc = 0;
+    for (int i = 0; i < words; ++i) {
+        dst[i] = a[i] & b[i];
+        acc |= dst[i];
+    }
+    return acc != 0;
+#endif
+}
+
+// dst = a & ~b; возвращает true, если результат не пуст
+inline bool bitsAndNot(uint64_t* dst, const uint64_t* a, const uint64_t* b, int words) {
+#if defined(__AVX512F__)
+    __m512i acc = _mm512_setzero_si512();
+    for (int i = 0; i < words; i += 8) {
+        __m512i x = _mm512_load_si512((const void*)(a + i));
+        __m512i y = _mm512_load_si512((const void*)(b + i));
+        __m512i r = _mm512_andnot_si512(y, x);
+        _mm512_store_si512((void*)(dst + i), r);
+        acc = _mm512_or_si512(acc, r);
+    }
+    return _mm512_test_epi64_mask(acc, acc) != 0;
+#elif defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (int i = 0; i < words; i += 4) {
+        __m256i x = _mm256_load_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_load_si256((const __m256i*)(b + i));
+        __m256i r = _mm256_andnot_si256(y, x);
+        _mm256_store_si256((__m256i*)(dst + i), r);
+        acc = _mm256_or_si256(acc, r);
+    }
+    return !_mm256_testz_si256(acc, acc);
+#else
+    uint64_t acc = 0;
+    for (int i = 0; i < words; ++i) {
+        dst[i] = a[i] & ~b[i];
+        acc |= dst[i];
+    }
+    return acc != 0;
+#endif
+}
+
+inline bool bitsAny(const uint64_t* bits, int words) {
+    for (int i = 0; i < words; ++i) {
+        if (bits[i]) return true;
+    }
+    return false;
+}
+
+inline int bitsCount(const uint64_t* bits, int words) {
+    int count = 0;
+    for (int i = 0; i < words; ++i) {
+        count += bitCountWord(bits[i]);
+    }
+    return count;
+}
+
+// Обход установленных бит по возрастанию
+template <typename Func>
+inline void bitsForEach(const uint64_t* bits, int words, Func func) {
+    for (int i = 0; i < words; ++i) {
+        uint64_t w = bits[i];
+        while (w) {
+            func(i * BIT_WORD_BITS + bitLowestWord(w));
+            w &= w - 1;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,336 @@
+#ifndef CONTINUOUS_QUERY_H
+#define CONTINUOUS_QUERY_H
+
+#include <functional>
+#include "Graph.h"
+
+using namespace std;
+
+// Обработчик изменения: added == true — сопоставление появилось, false — исчезло
+using MatchDeltaCallback = function<void(const vector<int>& mapping, bool added)>;
+
+// Непрерывный запрос: паттерн, подписанный на изменения графа. При подписке обработчик
+// получает все текущие сопоставления как появившиеся, дальше — только разницу.
+// Изменение ребра (u, v) затрагивает лишь сопоставления, в которых на {u, v} ложится пара
+// вершин паттерна (при индуцированном поиске — любая пара, иначе — ребро паттерна), поэтому
+// они ищутся от закреплённой пары до и после изменения; смена метки вершины — так же от
+// одной закреплённой вершины. generateRandom и присваивание графа обрабатываются полным поиском.
+// Используются SearchOptions::semantics, symmetry (Break — по одному сопоставлению
+// на класс) и threads (для полного поиска). Обработчик не должен менять граф
+class ContinuousQuery : private GraphObserver {
+private:
+    // Порядок сопоставления, начинающийся с закреплённых вершин паттерна
+    struct AnchoredOrder {
+        int anchors = 0;
+        vector<int> order;
+        vector<vector<int>> back;       // позиции смежных с order[depth] вершин префикса
+        vector<vector<int>> nonBack;    // остальные позиции префикса (для индуцированного)
+        vector<vector<int>> greater;    // позиции, образ которых должен быть меньше
+        vector<vector<int>> less;       // позиции, образ которых должен быть больше
+    };
+
+    Graph* target;
+    Graph pattern;
+    MatchDeltaCallback callback;
+    SearchOptions options;
+    bool injective;
+    bool induced;
+    PatternSymmetry symmetry;
+    vector<pair<int, int>> symmetryPairs;   // f(first) < f(second) для канонических
+
+    vector<pair<int, int>> anchorPairs;     // пары паттерна, на которые может лечь ребро
+    vector<AnchoredOrder> pairOrders;
+    vector<AnchoredOrder> vertexOrders;
+    vector<vector<int>> beforeChange;       // затронутые сопоставления до изменения
+    uint64_t matchCount;
+
+    vector<int> image;
+    vector<char> used;
+    vector<int> mapping;
+
+    AnchoredOrder buildOrder(const vector<int>& anchors) const;
+    bool fits(const AnchoredOrder& order, int depth, int x) const;
+    void extend(const AnchoredOrder& order, int depth, const function<void()>& leaf);
+    void collectEdge(int u, int v, vector<vector<int>>& found);
+    void collectVertex(int v, vector<vector<int>>& found);
+    void fullSearch(bool added);
+    void report(vector<vector<int>>& before, vector<vector<int>>& after);
+
+    void beforeEdgeChange(int u, int v) override;
+    void afterEdgeChange(int u, int v) override;
+    void beforeVertexChange(int v) override;
+    void afterVertexChange(int v) override;
+    void beforeReset() override;
+    void afterReset() override;
+    void graphDestroyed() override { target = nullptr; }
+
+public:
+    ContinuousQuery(Graph& graph, const Graph& queryPattern, MatchDeltaCallback onDelta,
+                    const SearchOptions& searchOptions = SearchOptions());
+    ~ContinuousQuery();
+    ContinuousQuery(const ContinuousQuery&) = delete;
+    ContinuousQuery& operator=(const ContinuousQuery&) = delete;
+
+    uint64_t getMatchCount() const { return matchCount; }
+    bool isAttached() const { return target != nullptr; }
+    void detach();
+};
+
+inline ContinuousQuery::ContinuousQuery(Graph& graph, const Graph& queryPattern, MatchDeltaCallback onDelta,
+                                        const SearchOptions& searchOptions)
+    : target(&graph), pattern(queryPattern), callback(move(onDelta)), options(searchOptions), matchCount(0) {
+    // План, группа и индекс графа из options относятся к неизменному графу; здесь они свои
+    options.plan = nullptr;
+    options.targetIndex = nullptr;
+    options.control = nullptr;
+#ifdef SUBGRAPH_SEARCH_STATS
+    options.stats = nullptr;
+#endif
+    injective = options.semantics != MatchSemantics::Homomorphism;
+    induced = options.semantics == MatchSemantics::Induced;
+    if (breaksSymmetry(options)) {
+        options.symmetry = SymmetryMode::Break;
+        symmetry = pattern.findAutomorphisms();
+        options.automorphisms = &symmetry;
+        for (size_t i = 0; i < symmetry.base.size(); ++i) {
+            for (size_t j = 1; j < symmetry.orbits[i].size(); ++j) {
+                symmetryPairs.push_back({symmetry.base[i], symmetry.orbits[i][j]});
+            }
+        }
+    } else {
+        options.symmetry = SymmetryMode::None;
+        options.automorphisms = nullptr;
+    }
+
+    int k = pattern.getVertexCount();
+    for (int a = 0; a < k; ++a) {
+        for (int b = 0; b < k; ++b) {
+            if (a != b && (induced || pattern.hasEdge(a, b))) {
+                anchorPairs.push_back({a, b});
+                pairOrders.push_back(buildOrder({a, b}));
+            }
+        }
+        vertexOrders.push_back(buildOrder({a}));
+    }
+    image.assign(k, -1);
+    mapping.assign(k, -1);
+    used.assign(graph.getVertexCount(), 0);
+
+    target->addObserver(this);
+    fullSearch(true);
+}
+
+inline ContinuousQuery::~ContinuousQuery() {
+    detach();
+}
+
+inline void ContinuousQuery::detach() {
+    if (target != nullptr) {
+        target->removeObserver(this);
+        target = nullptr;
+    }
+}
+
+// После закреплённых — вершина с наибольшим числом рёбер к уже поставленным, затем с большей степенью
+inline ContinuousQuery::AnchoredOrder ContinuousQuery::buildOrder(const vector<int>& anchors) const {
+    int k = pattern.getVertexCount();
+    AnchoredOrder result;
+    result.anchors = (int)anchors.size();
+    result.order = anchors;
+    vector<int> position(k, -1);
+    for (size_t i = 0; i < anchors.size(); ++i) position[anchors[i]] = (int)i;
+    while ((int)result.order.size() < k) {
+        int best = -1;
+        int bestLinks = -1;
+        for (int u = 0; u < k; ++u) {
+            if (position[u] >= 0) continue;
+            int links = 0;
+            for (int w : pattern.getNeighbors(u)) links += position[w] >= 0;
+            if (links > bestLinks || (links == bestLinks && pattern.getDegree(u) > pattern.getDegree(best))) {
+                best = u;
+                bestLinks = links;
+            }
+        }
+        position[best] = (int)result.order.size();
+        result.order.push_back(best);
+    }
+
+    result.back.resize(k);
+    result.nonBack.resize(k);
+    result.greater.resize(k);
+    result.less.resize(k);
+    for (int depth = 0; depth < k; ++depth) {
+        int u = result.order[depth];
+        for (int earlier = 0; earlier < depth; ++earlier) {
+            if (pattern.hasEdge(u, result.order[earlier])) {
+                result.back[depth].push_back(earlier);
+            } else if (induced) {
+                result.nonBack[depth].push_back(earlier);
+            }
+        }
+    }
+    for (const auto& pair : symmetryPairs) {
+        int low = position[pair.first];
+        int high = position[pair.second];
+        if (low < high) {
+            result.greater[high].push_back(low);
+        } else {
+            result.less[low].push_back(high);
+        }
+    }
+    return result;
+}
+
+inline bool ContinuousQuery::fits(const AnchoredOrder& order, int depth, int x) const {
+    int u = order.order[depth];
+    if (target->getVertexLabel(x) != pattern.getVertexLabel(u)) return false;
+    if (injective && (used[x] || target->getDegree(x) < pattern.getDegree(u))) return false;
+    for (int position : order.back[depth]) {
+        int w = image[position];
+        if (!target->hasEdge(x, w)) return false;
+        if (target->getEdgeLabel(x, w) != pattern.getEdgeLabel(u, order.order[position])) return false;
+    }
+    for (int position : order.nonBack[depth]) {
+        if (target->hasEdge(x, image[position])) return false;
+    }
+    for (int position : order.greater[depth]) {
+        if (x <= image[position]) return false;
+    }
+    for (int position : order.less[depth]) {
+        if (x >= image[position]) return false;
+    }
+    return true;
+}
+
+// Позиции до order.anchors уже заполнены; кандидаты — соседи образа смежной позиции с наименьшей степенью
+inline void ContinuousQuery::extend(const AnchoredOrder& order, int depth, const function<void()>& leaf) {
+    int k = (int)order.order.size();
+    if (depth == k) {
+        for (int d = 0; d < k; ++d) mapping[order.order[d]] = image[d];
+        leaf();
+        return;
+    }
+    auto tryVertex = [&](int x) {
+        if (!fits(order, depth, x)) return;
+        image[depth] = x;
+        if (injective) used[x] = 1;
+        extend(order, depth + 1, leaf);
+        if (injective) used[x] = 0;
+    };
+    if (order.back[depth].empty()) {
+        for (int x = 0; x < target->getVertexCount(); ++x) tryVertex(x);
+        return;
+    }
+    int anchor = image[order.back[depth][0]];
+    for (int position : order.back[depth]) {
+        if (target->getDegree(image[position]) < target->getDegree(anchor)) anchor = image[position];
+    }
+    for (int x : target->getNeighbors(anchor)) tryVertex(x);
+}
+
+// При гомоморфизме на (u, v) может лечь несколько пар паттерна; сопоставление
+// засчитывается той из них, что стоит раньше в anchorPairs
+inline void ContinuousQuery::collectEdge(int u, int v, vector<vector<int>>& found) {
+    found.clear();
+    for (size_t i = 0; i < anchorPairs.size(); ++i) {
+        const AnchoredOrder& order = pairOrders[i];
+        bool anchored = true;
+        for (int depth = 0; depth < order.anchors && anchored; ++depth) {
+            int x = depth == 0 ? u : v;
+            anchored = fits(order, depth, x);
+            image[depth] = x;
+            if (anchored && injective) used[x] = 1;
+        }
+        if (anchored) {
+            extend(order, order.anchors, [&]() {
+                for (size_t j = 0; j < i; ++j) {
+                    if (mapping[anchorPairs[j].first] == u && mapping[anchorPairs[j].second] == v) return;
+                }
+                found.push_back(mapping);
+            });
+        }
+        if (injective) {
+            used[u] = 0;
+            used[v] = 0;
+        }
+    }
+    sort(found.begin(), found.end());
+}
+
+inline void ContinuousQuery::collectVertex(int v, vector<vector<int>>& found) {
+    found.clear();
+    for (int a = 0; a < pattern.getVertexCount(); ++a) {
+        const AnchoredOrder& order = vertexOrders[a];
+        if (!fits(order, 0, v)) continue;
+        image[0] = v;
+        if (injective) used[v] = 1;
+        extend(order, 1, [&]() {
+            for (int earlier = 0; earlier < a; ++earlier) {
+                if (mapping[earlier] == v) return;
+            }
+            found.push_back(mapping);
+        });
+        if (injective) used[v] = 0;
+    }
+    sort(found.begin(), found.end());
+}
+
+inline void ContinuousQuery::fullSearch(bool added) {
+    auto deliver = [&](const vector<int>& match) {
+        matchCount += added ? 1 : -1;
+        callback(match, added);
+        return true;
+    };
+    // Мимо перенумерованной копии: Break выбирает представителей классов в тех же
+    // номерах, что и локальные поиски (fits), иначе разница не сходится с начальным набором
+    subgraphStream(*target, pattern, options, deliver);
+}
+
+// Пересечение не изменилось (например, при смене метки на ребре, не лежащем на паттерне)
+inline void ContinuousQuery::report(vector<vector<int>>& before, vector<vector<int>>& after) {
+    size_t i = 0, j = 0;
+    while (i < before.size() || j < after.size()) {
+        if (j == after.size() || (i < before.size() && before[i] < after[j])) {
+            matchCount--;
+            callback(before[i++], false);
+        } else if (i == before.size() || after[j] < before[i]) {
+            matchCount++;
+            callback(after[j++], true);
+        } else {
+            ++i;
+            ++j;
+        }
+    }
+    before.clear();
+}
+
+inline void ContinuousQuery::beforeEdgeChange(int u, int v) {
+    collectEdge(u, v, beforeChange);
+}
+
+inline void ContinuousQuery::afterEdgeChange(int u, int v) {
+    vector<vector<int>> after;
+    collectEdge(u, v, after);
+    report(beforeChange, after);
+}
+
+inline void ContinuousQuery::beforeVertexChange(int v) {
+    collectVertex(v, beforeChange);
+}
+
+inline void ContinuousQuery::afterVertexChange(int v) {
+    vector<vector<int>> after;
+    collectVertex(v, after);
+    report(beforeChange, after);
+}
+
+inline void ContinuousQuery::beforeReset() {
+    fullSearch(false);
+}
+
+inline void ContinuousQuery::afterReset() {
+    used.assign(target->getVertexCount(), 0);
+    fullSearch(true);
+}
+
+#endif
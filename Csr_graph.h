@@ -0,0 +1,333 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include "Graph.h"
+
+using namespace std;
+
+// Массивы готового графа во внешней памяти, например в отображённом файле снимка
+struct CsrArrays {
+    int vertices = 0;
+    const int64_t* offsets = nullptr;       // vertices + 1 элемент
+    const int* neighbors = nullptr;         // offsets[vertices] элементов
+    const int* degrees = nullptr;
+    const int* vertexLabels = nullptr;      // nullptr — все метки нулевые
+    const int* edgeLabels = nullptr;        // параллельно neighbors; nullptr — все нулевые
+};
+
+// Неизменяемый граф в формате CSR: соседи всех вершин лежат в одном массиве,
+// offsets[v]..offsets[v + 1] — окрестность v, отсортированная по возрастанию.
+// Подходит для больших разреженных графов, где матрица V x V не помещается в память.
+// Массивы либо принадлежат графу, либо лежат во внешней памяти (view)
+class CsrGraph {
+private:
+    int V;
+    vector<int64_t> offsetStore;
+    vector<int> neighborStore;
+    vector<int> degreeStore;
+    vector<int> vertexLabelStore;
+    vector<int> edgeLabelStore;
+    // Рабочие указатели: на собственные массивы или на внешнюю память
+    const int64_t* offsets;
+    const int* neighbors;
+    const int* degrees;
+    const int* vertexLabels;
+    const int* edgeLabels;
+    shared_ptr<const void> owner;   // держит внешнюю память, пока жив граф
+    BitVector adjMatrix;            // необязательная плотная матрица, см. buildAdjMatrix
+    int rowWords;
+
+    void build(const vector<pair<int, int>>& edges, const vector<int>& labels);
+    void bindStorage();
+
+public:
+    // Диапазон соседей вершины без копирования
+    struct NeighborRange {
+        const int* first;
+        const int* last;
+        const int* begin() const { return first; }
+        const int* end() const { return last; }
+        int size() const { return (int)(last - first); }
+    };
+
+    CsrGraph();
+    // labels — метки вершин, edgeLabelList — метки рёбер в порядке edges (пустые — нули).
+    // Для повторного ребра сохраняется метка первого вхождения
+    CsrGraph(int vertices, const vector<pair<int, int>>& edges,
+             const vector<int>& labels = vector<int>(), const vector<int>& edgeLabelList = vector<int>());
+    explicit CsrGraph(const Graph& graph);
+    CsrGraph(const CsrGraph& other);
+    CsrGraph& operator=(const CsrGraph& other);
+    CsrGraph(CsrGraph&& other) = default;
+    CsrGraph& operator=(CsrGraph&& other) = default;
+
+    // Граф поверх чужих массивов без копирования; owner продлевает жизнь памяти
+    static CsrGraph view(const CsrArrays& arrays, shared_ptr<const void> owner);
+    bool isView() const { return owner != nullptr; }
+    CsrArrays getArrays() const { return {V, offsets, neighbors, degrees, vertexLabels, edgeLabels}; }
+
+    int getVertexCount() const { return V; }
+    int64_t getEdgeCount() const { return offsets[V] / 2; }
+    int getDegree(int v) const;
+    bool hasEdge(int u, int v) const;
+    NeighborRange getNeighbors(int v) const {
+        return {neighbors + offsets[v], neighbors + offsets[v + 1]};
+    }
+
+    int getVertexLabel(int v) const { return vertexLabels ? vertexLabels[v] : 0; }
+    bool hasVertexLabels() const { return vertexLabels != nullptr; }
+    int getEdgeLabel(int u, int v) const;
+    bool hasEdgeLabels() const { return edgeLabels != nullptr; }
+
+    // Плотная матрица смежности строится по требованию: с ней доступен
+    // перебор с возвратом и проверка ребра за O(1), но память растёт как V^2 / 8
+    void buildAdjMatrix();
+    bool hasAdjMatrix() const { return !adjMatrix.empty(); }
+    const uint64_t* getAdjRow(int v) const { return adjMatrix.data() + (size_t)v * rowWords; }
+    int getRowWords() const { return rowWords; }
+
+    // Тот же интерфейс поиска, что и у Graph; паттерн задаётся обычным Graph.
+    // Без плотной матрицы поиск всегда идёт через VF2++
+    vector<vector<int>> findIsomorphicSubgraph(const Graph& pattern,
+                                               const SearchOptions& options = SearchOptions()) const;
+    MatchPlan planMatching(const Graph& pattern) const;
+    bool findIsomorphicSubgraph(const Graph& pattern, const MatchVisitor& visitor,
+                                const SearchOptions& options = SearchOptions()) const;
+    bool findFirst(const Graph& pattern, vector<int>& mapping,
+                   const SearchOptions& options = SearchOptions()) const;
+    vector<vector<int>> findK(const Graph& pattern, size_t k,
+                              const SearchOptions& options = SearchOptions()) const;
+    bool exists(const Graph& pattern, const SearchOptions& options = SearchOptions()) const;
+    MatchCount countIsomorphicSubgraphs(const Graph& pattern,
+                                        const SearchOptions& options = SearchOptions(),
+                                        bool distinctVertexSets = false) const;
+};
+
+inline CsrGraph::CsrGraph() : V(0), offsetStore(1, 0), rowWords(0) {
+    bindStorage();
+}
+
+inline CsrGraph::CsrGraph(int vertices, const vector<pair<int, int>>& edges,
+                          const vector<int>& labels, const vector<int>& edgeLabelList)
+    : V(vertices > 0 ? vertices : 0), rowWords(0) {
+    if (any_of(labels.begin(), labels.end(), [](int label) { return label != 0; })) {
+        vertexLabelStore = labels;
+        vertexLabelStore.resize(V, 0);
+    }
+    build(edges, edgeLabelList);
+}
+
+inline CsrGraph::CsrGraph(const Graph& graph) : V(graph.getVertexCount()), rowWords(0) {
+    vector<pair<int, int>> edges;
+    vector<int> labels;
+    edges.reserve(graph.getEdgeCount());
+    for (int u = 0; u < V; ++u) {
+        for (int v : graph.getNeighbors(u)) {
+            if (u < v) {
+                edges.push_back({u, v});
+                if (graph.hasEdgeLabels()) labels.push_back(graph.getEdgeLabel(u, v));
+            }
+        }
+    }
+    if (graph.hasVertexLabels()) {
+        vertexLabelStore.resize(V);
+        for (int v = 0; v < V; ++v) {
+            vertexLabelStore[v] = graph.getVertexLabel(v);
+        }
+    }
+    build(edges, labels);
+}
+
+// Копия собственного графа указывает на свои массивы, копия представления — на ту же память
+inline CsrGraph::CsrGraph(const CsrGraph& other)
+    : V(other.V), offsetStore(other.offsetStore), neighborStore(other.neighborStore),
+      degreeStore(other.degreeStore), vertexLabelStore(other.vertexLabelStore),
+      edgeLabelStore(other.edgeLabelStore), offsets(other.offsets), neighbors(other.neighbors),
+      degrees(other.degrees), vertexLabels(other.vertexLabels), edgeLabels(other.edgeLabels),
+      owner(other.owner), adjMatrix(other.adjMatrix), rowWords(other.rowWords) {
+    if (!owner) bindStorage();
+}
+
+inline CsrGraph& CsrGraph::operator=(const CsrGraph& other) {
+    if (this != &other) {
+        CsrGraph copy(other);
+        *this = move(copy);
+    }
+    return *this;
+}
+
+inline CsrGraph CsrGraph::view(const CsrArrays& arrays, shared_ptr<const void> owner) {
+    CsrGraph graph;
+    graph.V = arrays.vertices;
+    graph.offsetStore.clear();
+    graph.offsets = arrays.offsets;
+    graph.neighbors = arrays.neighbors;
+    graph.degrees = arrays.degrees;
+    graph.vertexLabels = arrays.vertexLabels;
+    graph.edgeLabels = arrays.edgeLabels;
+    graph.owner = move(owner);
+    return graph;
+}
+
+inline void CsrGraph::bindStorage() {
+    offsets = offsetStore.data();
+    neighbors = neighborStore.data();
+    degrees = degreeStore.data();
+    vertexLabels = vertexLabelStore.empty() ? nullptr : vertexLabelStore.data();
+    edgeLabels = edgeLabelStore.empty() ? nullptr : edgeLabelStore.data();
+}
+
+// Сортировка подсчётом по первой вершине, затем сортировка и удаление
+// повторов внутри каждой строки; петли и рёбра вне диапазона отбрасываются
+inline void CsrGraph::build(const vector<pair<int, int>>& edges, const vector<int>& labels) {
+    bool labelled = any_of(labels.begin(), labels.end(), [](int label) { return label != 0; });
+    offsetStore.assign((size_t)V + 1, 0);
+    for (const auto& edge : edges) {
+        int u = edge.first;
+        int v = edge.second;
+        if (u >= 0 && u < V && v >= 0 && v < V && u != v) {
+            offsetStore[u + 1]++;
+            offsetStore[v + 1]++;
+        }
+    }
+    for (int v = 0; v < V; ++v) {
+        offsetStore[v + 1] += offsetStore[v];
+    }
+
+    neighborStore.resize(offsetStore[V]);
+    if (labelled) edgeLabelStore.resize(offsetStore[V]);
+    vector<int64_t> fill(offsetStore.begin(), offsetStore.end() - 1);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        int u = edges[i].first;
+        int v = edges[i].second;
+        if (u >= 0 && u < V && v >= 0 && v < V && u != v) {
+            int label = i < labels.size() ? labels[i] : 0;
+            if (labelled) {
+                edgeLabelStore[fill[u]] = label;
+                edgeLabelStore[fill[v]] = label;
+            }
+            neighborStore[fill[u]++] = v;
+            neighborStore[fill[v]++] = u;
+        }
+    }
+
+    // Сжатие на месте: повторные рёбра удаляются, строки сдвигаются влево
+    vector<pair<int, int>> row;
+    int64_t write = 0;
+    for (int v = 0; v < V; ++v) {
+        int64_t from = offsetStore[v];
+        int64_t to = offsetStore[v + 1];
+        offsetStore[v] = write;
+        if (labelled) {
+            row.clear();
+            for (int64_t i = from; i < to; ++i) row.push_back({neighborStore[i], edgeLabelStore[i]});
+            stable_sort(row.begin(), row.end(),
+                        [](const pair<int, int>& a, const pair<int, int>& b) { return a.first < b.first; });
+            for (size_t i = 0; i < row.size(); ++i) {
+                if (i == 0 || row[i].first != row[i - 1].first) {
+                    neighborStore[write] = row[i].first;
+                    edgeLabelStore[write++] = row[i].second;
+                }
+            }
+            continue;
+        }
+        sort(neighborStore.begin() + from, neighborStore.begin() + to);
+        for (int64_t i = from; i < to; ++i) {
+            if (i == from || neighborStore[i] != neighborStore[i - 1]) {
+                neighborStore[write++] = neighborStore[i];
+            }
+        }
+    }
+    offsetStore[V] = write;
+    neighborStore.resize(write);
+    neighborStore.shrink_to_fit();
+    if (labelled) {
+        edgeLabelStore.resize(write);
+        edgeLabelStore.shrink_to_fit();
+    }
+    degreeStore.resize(V);
+    for (int v = 0; v < V; ++v) {
+        degreeStore[v] = (int)(offsetStore[v + 1] - offsetStore[v]);
+    }
+    bindStorage();
+}
+
+inline int CsrGraph::getDegree(int v) const {
+    if (v >= 0 && v < V) {
+        return degrees[v];
+    }
+    return 0;
+}
+
+inline bool CsrGraph::hasEdge(int u, int v) const {
+    if (u < 0 || u >= V || v < 0 || v >= V) {
+        return false;
+    }
+    if (hasAdjMatrix()) {
+        return bitTest(getAdjRow(u), v);
+    }
+    // Двоичный поиск в более короткой строке
+    if (getDegree(u) > getDegree(v)) {
+        swap(u, v);
+    }
+    NeighborRange row = getNeighbors(u);
+    return binary_search(row.begin(), row.end(), v);
+}
+
+inline int CsrGraph::getEdgeLabel(int u, int v) const {
+    if (!edgeLabels || u < 0 || u >= V) return 0;
+    NeighborRange row = getNeighbors(u);
+    const int* it = lower_bound(row.begin(), row.end(), v);
+    return it != row.end() && *it == v ? edgeLabels[it - neighbors] : 0;
+}
+
+inline void CsrGraph::buildAdjMatrix() {
+    rowWords = bitRowWords(V);
+    adjMatrix.assign((size_t)V * rowWords, 0);
+    for (int u = 0; u < V; ++u) {
+        uint64_t* row = adjMatrix.data() + (size_t)u * rowWords;
+        for (int v : getNeighbors(u)) {
+            bitSet(row, v);
+        }
+    }
+}
+
+inline vector<vector<int>> CsrGraph::findIsomorphicSubgraph(const Graph& pattern,
+                                                            const SearchOptions& options) const {
+    return subgraphSearch(*this, pattern, options);
+}
+
+inline MatchPlan CsrGraph::planMatching(const Graph& pattern) const {
+    return buildMatchPlan(*this, pattern);
+}
+
+inline bool CsrGraph::findIsomorphicSubgraph(const Graph& pattern, const MatchVisitor& visitor,
+                                             const SearchOptions& options) const {
+    return subgraphStream(*this, pattern, options, visitor);
+}
+
+inline bool CsrGraph::findFirst(const Graph& pattern, vector<int>& mapping,
+                                const SearchOptions& options) const {
+    return subgraphFindFirst(*this, pattern, mapping, options);
+}
+
+inline vector<vector<int>> CsrGraph::findK(const Graph& pattern, size_t k,
+                                           const SearchOptions& options) const {
+    return subgraphFindK(*this, pattern, k, options);
+}
+
+inline bool CsrGraph::exists(const Graph& pattern, const SearchOptions& options) const {
+    vector<int> mapping;
+    return findFirst(pattern, mapping, options);
+}
+
+inline MatchCount CsrGraph::countIsomorphicSubgraphs(const Graph& pattern, const SearchOptions& options,
+                                                     bool distinctVertexSets) const {
+    return subgraphCountMatches(*this, pattern, options, distinctVertexSets);
+}
+
+#endif
@@ -10,29 +10,92 @@
 #include <cmath>
 #include <string>
 #include <iomanip>
+#include <unordered_map>
 #include <unordered_set>
 #include <sstream>
+#include <memory>
+#include <atomic>
+#include "Bitset.h"
+#include "Graph_generators.h"
+#include "Graph_reorder.h"
+#include "Graph_canonical.h"
+#include "Subgraph_search.h"
+#include "Approximate_count.h"
 
 using namespace std;
 
+// Наблюдатель изменений графа (см. Continuous_query.h): before* вызывается до изменения,
+// after* — после. Сообщается только о том, что действительно меняет граф
+class GraphObserver {
+public:
+    virtual ~GraphObserver() {}
+    virtual void beforeEdgeChange(int u, int v) = 0;    // добавление, удаление, смена метки ребра
+    virtual void afterEdgeChange(int u, int v) = 0;
+    virtual void beforeVertexChange(int v) = 0;         // смена метки вершины
+    virtual void afterVertexChange(int v) = 0;
+    virtual void beforeReset() = 0;                     // generateRandom, присваивание
+    virtual void afterReset() = 0;
+    virtual void graphDestroyed() = 0;
+};
+
+// Подписка относится к объекту графа, поэтому при копировании и переносе список не передаётся
+struct GraphObserverList {
+    vector<GraphObserver*> items;
+
+    GraphObserverList() {}
+    GraphObserverList(const GraphObserverList&) {}
+    GraphObserverList& operator=(const GraphObserverList&) { return *this; }
+    ~GraphObserverList() {
+        for (GraphObserver* observer : vector<GraphObserver*>(items)) observer->graphDestroyed();
+    }
+};
+
+struct ReorderedGraph;
+
+// Номера версий общие для всех графов и не повторяются в пределах процесса
+inline uint64_t nextGraphVersion() {
+    static atomic<uint64_t> counter(0);
+    return ++counter;
+}
+
 class Graph {
 private:
     int V;
     vector<list<int>> adj;
-    vector<vector<bool>> adjMatrix;
+    BitVector adjMatrix;    // строки по rowWords слов, выровнены по кэш-линии
+    int rowWords;
+    vector<int> vertexLabels;
+    unordered_map<uint64_t, int> edgeLabels;   // только ненулевые метки, ключ — edgeKey
+    bool vertexLabelled;
+    uint64_t version;
+    // Перенумерованная копия для поиска; копии графа делят её до первого изменения
+    shared_ptr<ReorderedGraph> reordered;
+    GraphObserverList observers;    // последним: при разрушении графа наблюдатели видят его целым
     
     void buildAdjMatrix();
-    bool isIsomorphic(const Graph& other, const vector<int>& mapping) const;
-    bool backtrackIsomorphism(const Graph& pattern,
-                             vector<int>& mapping,
-                             vector<bool>& used,
-                             int depth,
-                             vector<vector<int>>& allMappings) const;
+    ReorderedGraph& ownReordered();
+    SearchOptions reorderedOptions(const SearchOptions& options) const;
+    void toOriginalIds(vector<int>& mapping) const;
+    void notifyEdgeChange(int u, int v, bool after);
+    void notifyVertexChange(int v, bool after);
+    void notifyReset(bool after);
+    static uint64_t edgeKey(int u, int v) {
+        return u < v ? (uint64_t)u << 32 | (uint32_t)v : (uint64_t)v << 32 | (uint32_t)u;
+    }
     
 public:
     Graph();
     explicit Graph(int vertices);
     Graph(const vector<pair<int, int>>& edges, int vertices);
+    Graph(const Graph& other) = default;
+    Graph(Graph&& other) = default;
+    // Для наблюдателей присваивание — смена всего графа
+    Graph& operator=(const Graph& other);
+    Graph& operator=(Graph&& other);
+    
+    // Наблюдатель должен отписаться до своего разрушения; о разрушении графа он узнаёт сам
+    void addObserver(GraphObserver* observer) { observers.items.push_back(observer); }
+    void removeObserver(GraphObserver* observer);
     
     void addEdge(int u, int v);
     void removeEdge(int u, int v);
@@ -40,39 +103,97 @@ public:
     int getDegree(int v) const;
     int getVertexCount() const { return V; }
     int getEdgeCount() const;
+    // Версия содержимого: меняется при каждом изменении графа (рёбра, метки, generateRandom,
+    // присваивание); копия получает версию оригинала. Равные версии — равное содержимое
+    uint64_t getVersion() const { return version; }
+    
+    // Метки (типы) вершин и рёбер; по умолчанию 0. При поиске метки
+    // вершины паттерна и её образа, как и метки рёбер, должны совпадать
+    void setVertexLabel(int v, int label);
+    int getVertexLabel(int v) const { return vertexLabels[v]; }
+    bool hasVertexLabels() const { return vertexLabelled; }
+    void setEdgeLabel(int u, int v, int label);
+    int getEdgeLabel(int u, int v) const;
+    bool hasEdgeLabels() const { return !edgeLabels.empty(); }
     
     void generateRandom(int vertices, double edgeProbability);
-    vector<vector<int>> findIsomorphicSubgraph(const Graph& pattern) const;
+    // То же с фиксированным зерном — для воспроизводимых замеров; G(n, p) за O(n + m), см. randomGnp
+    void generateRandom(int vertices, double edgeProbability, uint64_t seed);
+    vector<vector<int>> findIsomorphicSubgraph(const Graph& pattern,
+                                               MatchEngine engine = MatchEngine::Backtracking) const;
+    vector<vector<int>> findIsomorphicSubgraph(const Graph& pattern, const SearchOptions& options) const;
+    
+    // План запроса для паттерна; передаётся в поиск через SearchOptions::plan
+    MatchPlan planMatching(const Graph& pattern) const;    
+    // Потоковый поиск: visitor вызывается на каждое сопоставление, false — остановка.
+    // Возвращает true, если поиск дошёл до конца
+    bool findIsomorphicSubgraph(const Graph& pattern, const MatchVisitor& visitor,
+                                const SearchOptions& options = SearchOptions()) const;
+    bool findFirst(const Graph& pattern, vector<int>& mapping,
+                   const SearchOptions& options = SearchOptions()) const;
+    vector<vector<int>> findK(const Graph& pattern, size_t k,
+                              const SearchOptions& options = SearchOptions()) const;
+    bool exists(const Graph& pattern, const SearchOptions& options = SearchOptions()) const;
+    
+    // Перенумерация вершин для локальности при поиске (Graph_reorder.h). Поиск идёт по
+    // перенумерованной копии, а сопоставления переводятся обратно, так что все методы
+    // графа и найденные сопоставления по-прежнему в исходных номерах. Изменения графа
+    // переносятся в копию; None — отказ от копии. SearchOptions::targetIndex при
+    // перенумерации не используется: он построен в исходных номерах
+    void reorderVertices(VertexOrdering ordering);
+    VertexOrdering getVertexOrdering() const;
+    // order[внутренний номер] = исходный номер; пусто без перенумерации
+    const vector<int>& getVertexOrder() const;
+    
+    // Группа автоморфизмов графа как паттерна; передаётся в поиск через SearchOptions::automorphisms
+    PatternSymmetry findAutomorphisms() const { return buildPatternSymmetry(*this); }
+    // Каноническая нумерация и сертификат графа с точностью до изоморфизма (Graph_canonical.h)
+    CanonicalForm canonicalForm() const { return buildCanonicalForm(*this); }
+    
+    // Подсчёт вложений без сохранения сопоставлений
+    MatchCount countIsomorphicSubgraphs(const Graph& pattern,
+                                        const SearchOptions& options = SearchOptions(),
+                                        bool distinctVertexSets = false) const;
+    // Приближённый подсчёт сопоставлений с доверительным интервалом (Approximate_count.h)
+    MatchEstimate estimateIsomorphicSubgraphs(const Graph& pattern,
+                                              const EstimateOptions& options = EstimateOptions()) const;
     
     void printMatrix() const;
     void printInfo() const;
     
-    const vector<vector<bool>>& getAdjMatrix() const { return adjMatrix; }
+    const uint64_t* getAdjRow(int v) const { return adjMatrix.data() + (size_t)v * rowWords; }
+    int getRowWords() const { return rowWords; }
+    bool hasAdjMatrix() const { return true; }
     const vector<list<int>>& getAdjacencyList() const { return adj; }
+    const list<int>& getNeighbors(int v) const { return adj[v]; }
 };
 
 // Реализация методов класса Graph (inline)
 inline void Graph::buildAdjMatrix() {
-    adjMatrix.clear();
-    adjMatrix.resize(V, vector<bool>(V, false));
+    rowWords = bitRowWords(V);
+    adjMatrix.assign((size_t)V * rowWords, 0);
     
     for (int i = 0; i < V; ++i) {
         for (int neighbor : adj[i]) {
-            adjMatrix[i][neighbor] = true;
-            adjMatrix[neighbor][i] = true;
+            bitSet(adjMatrix.data() + (size_t)i * rowWords, neighbor);
+            bitSet(adjMatrix.data() + (size_t)neighbor * rowWords, i);
         }
     }
 }
 
-inline Graph::Graph() : V(0) {}
+inline Graph::Graph() : V(0), rowWords(0), vertexLabelled(false), version(nextGraphVersion()) {}
 
-inline Graph::Graph(int vertices) : V(vertices), adj(vertices) {
+inline Graph::Graph(int vertices)
+    : V(vertices), adj(vertices), rowWords(0), vertexLabels(vertices, 0), vertexLabelled(false),
+      version(nextGraphVersion()) {
     if (vertices > 0) {
         buildAdjMatrix();
     }
 }
 
-inline Graph::Graph(const vector<pair<int, int>>& edges, int vertices) : V(vertices), adj(vertices) {
+inline Graph::Graph(const vector<pair<int, int>>& edges, int vertices)
+    : V(vertices), adj(vertices), rowWords(0), vertexLabels(vertices, 0), vertexLabelled(false),
+      version(nextGraphVersion()) {
     for (const auto& edge : edges) {
         int u = edge.first;
         int v = edge.second;
@@ -84,30 +205,167 @@ inline Graph::Graph(const vector<pair<int, int>>& edges, int vertices) : V(verti
     buildAdjMatrix();
 }
 
+inline Graph& Graph::operator=(const Graph& other) {
+    if (this != &other) {
+        Graph copy(other);
+        *this = move(copy);
+    }
+    return *this;
+}
+
+inline Graph& Graph::operator=(Graph&& other) {
+    if (this != &other) {
+        notifyReset(false);
+        V = other.V;
+        adj = move(other.adj);
+        adjMatrix = move(other.adjMatrix);
+        rowWords = other.rowWords;
+        vertexLabels = move(other.vertexLabels);
+        edgeLabels = move(other.edgeLabels);
+        vertexLabelled = other.vertexLabelled;
+        version = other.version;
+        other.version = nextGraphVersion();
+        reordered = move(other.reordered);
+        notifyReset(true);
+    }
+    return *this;
+}
+
+struct ReorderedGraph {
+    VertexOrdering ordering = VertexOrdering::None;
+    vector<int> order;          // внутренний номер -> исходный
+    vector<int> position;       // исходный номер -> внутренний
+    Graph graph;
+};
+
+inline ReorderedGraph& Graph::ownReordered() {
+    if (reordered.use_count() > 1) reordered = make_shared<ReorderedGraph>(*reordered);
+    return *reordered;
+}
+
+inline void Graph::reorderVertices(VertexOrdering ordering) {
+    if (ordering == VertexOrdering::None) {
+        reordered.reset();
+        return;
+    }
+    auto result = make_shared<ReorderedGraph>();
+    result->ordering = ordering;
+    result->order = vertexOrder(*this, ordering);
+    result->position = inversePermutation(result->order);
+    vector<pair<int, int>> edges;
+    for (int v = 0; v < V; ++v) {
+        for (int w : adj[v]) {
+            if (v < w) edges.push_back({result->position[v], result->position[w]});
+        }
+    }
+    // Списки смежности копии идут по возрастанию номеров — соседи тоже рядом в памяти
+    sort(edges.begin(), edges.end());
+    result->graph = Graph(edges, V);
+    for (int v = 0; v < V; ++v) result->graph.setVertexLabel(result->position[v], vertexLabels[v]);
+    for (const auto& label : edgeLabels) {
+        int u = (int)(label.first >> 32);
+        int v = (int)(uint32_t)label.first;
+        result->graph.setEdgeLabel(result->position[u], result->position[v], label.second);
+    }
+    reordered = result;
+}
+
+inline VertexOrdering Graph::getVertexOrdering() const {
+    return reordered ? reordered->ordering : VertexOrdering::None;
+}
+
+inline const vector<int>& Graph::getVertexOrder() const {
+    static const vector<int> identity;
+    return reordered ? reordered->order : identity;
+}
+
+inline SearchOptions Graph::reorderedOptions(const SearchOptions& options) const {
+    SearchOptions result = options;
+    result.targetIndex = nullptr;
+    return result;
+}
+
+inline void Graph::toOriginalIds(vector<int>& mapping) const {
+    for (int& v : mapping) v = reordered->order[v];
+}
+
+inline void Graph::removeObserver(GraphObserver* observer) {
+    observers.items.erase(remove(observers.items.begin(), observers.items.end(), observer), observers.items.end());
+}
+
+// Обход по копии списка: наблюдатель может отписаться прямо из обработчика
+inline void Graph::notifyEdgeChange(int u, int v, bool after) {
+    if (observers.items.empty()) return;
+    for (GraphObserver* observer : vector<GraphObserver*>(observers.items)) {
+        if (after) {
+            observer->afterEdgeChange(u, v);
+        } else {
+            observer->beforeEdgeChange(u, v);
+        }
+    }
+}
+
+inline void Graph::notifyVertexChange(int v, bool after) {
+    if (observers.items.empty()) return;
+    for (GraphObserver* observer : vector<GraphObserver*>(observers.items)) {
+        if (after) {
+            observer->afterVertexChange(v);
+        } else {
+            observer->beforeVertexChange(v);
+        }
+    }
+}
+
+inline void Graph::notifyReset(bool after) {
+    if (observers.items.empty()) return;
+    for (GraphObserver* observer : vector<GraphObserver*>(observers.items)) {
+        if (after) {
+            observer->afterReset();
+        } else {
+            observer->beforeReset();
+        }
+    }
+}
+
 inline void Graph::addEdge(int u, int v) {
     if (u >= 0 && u < V && v >= 0 && v < V && u != v) {
         auto it = find(adj[u].begin(), adj[u].end(), v);
         if (it == adj[u].end()) {
+            notifyEdgeChange(u, v, false);
             adj[u].push_back(v);
             adj[v].push_back(u);
-            adjMatrix[u][v] = true;
-            adjMatrix[v][u] = true;
+            bitSet(adjMatrix.data() + (size_t)u * rowWords, v);
+            bitSet(adjMatrix.data() + (size_t)v * rowWords, u);
+            version = nextGraphVersion();
+            if (reordered) {
+                ReorderedGraph& copy = ownReordered();
+                copy.graph.addEdge(copy.position[u], copy.position[v]);
+            }
+            notifyEdgeChange(u, v, true);
         }
     }
 }
 
 inline void Graph::removeEdge(int u, int v) {
-    if (u >= 0 && u < V && v >= 0 && v < V) {
+    if (hasEdge(u, v)) {
+        notifyEdgeChange(u, v, false);
         adj[u].remove(v);
         adj[v].remove(u);
-        adjMatrix[u][v] = false;
-        adjMatrix[v][u] = false;
+        edgeLabels.erase(edgeKey(u, v));
+        bitClear(adjMatrix.data() + (size_t)u * rowWords, v);
+        bitClear(adjMatrix.data() + (size_t)v * rowWords, u);
+        version = nextGraphVersion();
+        if (reordered) {
+            ReorderedGraph& copy = ownReordered();
+            copy.graph.removeEdge(copy.position[u], copy.position[v]);
+        }
+        notifyEdgeChange(u, v, true);
     }
 }
 
 inline bool Graph::hasEdge(int u, int v) const {
     if (u >= 0 && u < V && v >= 0 && v < V) {
-        return adjMatrix[u][v];
+        return bitTest(getAdjRow(u), v);
     }
     return false;
 }
@@ -119,6 +377,42 @@ inline int Graph::getDegree(int v) const {
     return 0;
 }
 
+inline void Graph::setVertexLabel(int v, int label) {
+    if (v >= 0 && v < V && vertexLabels[v] != label) {
+        notifyVertexChange(v, false);
+        vertexLabels[v] = label;
+        vertexLabelled = vertexLabelled || label != 0;
+        version = nextGraphVersion();
+        if (reordered) {
+            ReorderedGraph& copy = ownReordered();
+            copy.graph.setVertexLabel(copy.position[v], label);
+        }
+        notifyVertexChange(v, true);
+    }
+}
+
+inline void Graph::setEdgeLabel(int u, int v, int label) {
+    if (!hasEdge(u, v) || getEdgeLabel(u, v) == label) return;
+    notifyEdgeChange(u, v, false);
+    if (label != 0) {
+        edgeLabels[edgeKey(u, v)] = label;
+    } else {
+        edgeLabels.erase(edgeKey(u, v));
+    }
+    version = nextGraphVersion();
+    if (reordered) {
+        ReorderedGraph& copy = ownReordered();
+        copy.graph.setEdgeLabel(copy.position[u], copy.position[v], label);
+    }
+    notifyEdgeChange(u, v, true);
+}
+
+inline int Graph::getEdgeLabel(int u, int v) const {
+    if (edgeLabels.empty()) return 0;
+    auto it = edgeLabels.find(edgeKey(u, v));
+    return it == edgeLabels.end() ? 0 : it->second;
+}
+
 inline int Graph::getEdgeCount() const {
     int count = 0;
     for (int i = 0; i < V; ++i) {
@@ -128,107 +422,90 @@ inline int Graph::getEdgeCount() const {
 }
 
 inline void Graph::generateRandom(int vertices, double edgeProbability) {
+    random_device rd;
+    generateRandom(vertices, edgeProbability, rd());
+}
+
+inline void Graph::generateRandom(int vertices, double edgeProbability, uint64_t seed) {
+    notifyReset(false);
     V = vertices;
     adj.clear();
     adj.resize(V);
+    vertexLabels.assign(V, 0);
+    edgeLabels.clear();
+    vertexLabelled = false;
     
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_real_distribution<> dis(0.0, 1.0);
-    
-    for (int i = 0; i < V; ++i) {
-        for (int j = i + 1; j < V; ++j) {
-            if (dis(gen) < edgeProbability) {
-                adj[i].push_back(j);
-                adj[j].push_back(i);
-            }
-        }
+    for (const auto& edge : randomGnp(V, edgeProbability, seed, 1)) {
+        adj[edge.first].push_back(edge.second);
+        adj[edge.second].push_back(edge.first);
     }
     
     buildAdjMatrix();
+    version = nextGraphVersion();
+    // Новый граф перенумеровывается тем же способом
+    if (reordered) reorderVertices(reordered->ordering);
+    notifyReset(true);
 }
 
-inline bool Graph::isIsomorphic(const Graph& other, const vector<int>& mapping) const {
-    int patternV = other.getVertexCount();
-    
-    unordered_set<int> used;
-    for (int i = 0; i < patternV; ++i) {
-        if (mapping[i] < 0 || mapping[i] >= V) return false;
-        if (used.count(mapping[i])) return false;
-        used.insert(mapping[i]);
-    }
-    
-    for (int i = 0; i < patternV; ++i) {
-        for (int j = i + 1; j < patternV; ++j) {
-            if (other.hasEdge(i, j) != hasEdge(mapping[i], mapping[j])) {
-                return false;
-            }
-        }
-    }
-    
-    return true;
+inline MatchPlan Graph::planMatching(const Graph& pattern) const {
+    return buildMatchPlan(*this, pattern);
 }
 
-inline bool Graph::backtrackIsomorphism(const Graph& pattern,
-                                       vector<int>& mapping,
-                                       vector<bool>& used,
-                                       int depth,
-                                       vector<vector<int>>& allMappings) const {
-    int patternV = pattern.getVertexCount();
-    
-    if (depth == patternV) {
-        if (isIsomorphic(pattern, mapping)) {
-            allMappings.push_back(mapping);
-            return true;
-        }
-        return false;
-    }
-    
-    bool found = false;
-    
-    for (int v = 0; v < V; ++v) {
-        if (!used[v]) {
-            if (pattern.getDegree(depth) > getDegree(v)) {
-                continue;
-            }
-            
-            mapping[depth] = v;
-            bool compatible = true;
-            
-            for (int i = 0; i < depth; ++i) {
-                if (pattern.hasEdge(i, depth) != hasEdge(mapping[i], v)) {
-                    compatible = false;
-                    break;
-                }
-            }
-            
-            if (compatible) {
-                used[v] = true;
-                found = backtrackIsomorphism(pattern, mapping, used, depth + 1, allMappings) || found;
-                used[v] = false;
-            }
-            
-            mapping[depth] = -1;
-        }
-    }
-    
+inline vector<vector<int>> Graph::findIsomorphicSubgraph(const Graph& pattern, MatchEngine engine) const {
+    SearchOptions options;
+    options.engine = engine;
+    return findIsomorphicSubgraph(pattern, options);
+}
+
+inline vector<vector<int>> Graph::findIsomorphicSubgraph(const Graph& pattern, const SearchOptions& options) const {
+    if (!reordered) return subgraphSearch(*this, pattern, options);
+    vector<vector<int>> mappings = subgraphSearch(reordered->graph, pattern, reorderedOptions(options));
+    for (vector<int>& mapping : mappings) toOriginalIds(mapping);
+    sort(mappings.begin(), mappings.end());
+    return mappings;
+}
+
+inline bool Graph::findIsomorphicSubgraph(const Graph& pattern, const MatchVisitor& visitor,
+                                          const SearchOptions& options) const {
+    if (!reordered) return subgraphStream(*this, pattern, options, visitor);
+    // subgraphStream вызывает обработчик под блокировкой, буфер общий
+    vector<int> original;
+    MatchVisitor translate = [&](const vector<int>& mapping) {
+        original = mapping;
+        toOriginalIds(original);
+        return visitor(original);
+    };
+    return subgraphStream(reordered->graph, pattern, reorderedOptions(options), translate);
+}
+
+inline bool Graph::findFirst(const Graph& pattern, vector<int>& mapping, const SearchOptions& options) const {
+    if (!reordered) return subgraphFindFirst(*this, pattern, mapping, options);
+    bool found = subgraphFindFirst(reordered->graph, pattern, mapping, reorderedOptions(options));
+    if (found) toOriginalIds(mapping);
     return found;
 }
 
-inline vector<vector<int>> Graph::findIsomorphicSubgraph(const Graph& pattern) const {
-    vector<vector<int>> allMappings;
-    
-    int patternV = pattern.getVertexCount();
-    if (patternV > V) {
-        return allMappings;
-    }
-    
-    vector<int> mapping(patternV, -1);
-    vector<bool> used(V, false);
-    
-    backtrackIsomorphism(pattern, mapping, used, 0, allMappings);
-    
-    return allMappings;
+inline vector<vector<int>> Graph::findK(const Graph& pattern, size_t k, const SearchOptions& options) const {
+    if (!reordered) return subgraphFindK(*this, pattern, k, options);
+    vector<vector<int>> mappings = subgraphFindK(reordered->graph, pattern, k, reorderedOptions(options));
+    for (vector<int>& mapping : mappings) toOriginalIds(mapping);
+    return mappings;
+}
+
+inline bool Graph::exists(const Graph& pattern, const SearchOptions& options) const {
+    vector<int> mapping;
+    return findFirst(pattern, mapping, options);
+}
+
+inline MatchCount Graph::countIsomorphicSubgraphs(const Graph& pattern, const SearchOptions& options,
+                                                  bool distinctVertexSets) const {
+    if (reordered) return subgraphCountMatches(reordered->graph, pattern, reorderedOptions(options), distinctVertexSets);
+    return subgraphCountMatches(*this, pattern, options, distinctVertexSets);
+}
+
+inline MatchEstimate Graph::estimateIsomorphicSubgraphs(const Graph& pattern, const EstimateOptions& options) const {
+    if (reordered) return estimateMatches(reordered->graph, pattern, options);
+    return estimateMatches(*this, pattern, options);
 }
 
 inline void Graph::printMatrix() const {
@@ -241,7 +518,7 @@ inline void Graph::printMatrix() const {
     for (int i = 0; i < V; ++i) {
         cout << i << ":" << " ";
         for (int j = 0; j < V; ++j) {
-            cout << (adjMatrix[i][j] ? "1" : "0") << ' ';
+            cout << (hasEdge(i, j) ? "1" : "0") << ' ';
         }
         cout << "\n";
     }
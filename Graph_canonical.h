@@ -0,0 +1,240 @@
+#ifndef GRAPH_CANONICAL_H
+#define GRAPH_CANONICAL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Graph_generators.h"
+#include "Graph_reorder.h"
+
+using namespace std;
+
+// Каноническая нумерация графа с метками: графы, изоморфные с учётом меток вершин
+// и рёбер, получают один и тот же certificate, неизоморфные — разные, поэтому
+// certificate годится как ключ паттерна (см. Query_cache.h)
+struct CanonicalForm {
+    vector<int> order;          // order[канонический номер] = номер в графе
+    vector<int> position;       // номер в графе -> канонический
+    string certificate;         // граф в канонических номерах
+    uint64_t hash = 0;          // certificateHash(certificate)
+};
+
+// FNV-1a с перемешиванием в конце; не зависит от реализации стандартной библиотеки,
+// так что годится для имён файлов
+inline uint64_t certificateHash(const string& bytes) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : bytes) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return mixSeed(h);
+}
+
+// Уточнение раскраски с индивидуализацией (схема nauty). Раскраска — номера клеток
+// упорядоченного разбиения; клетки делятся по числу соседей каждого цвета, пока
+// разбиение мельчает. Если клетки не все одиночные, каждая вершина наименьшей
+// неодиночной клетки по очереди выделяется в свою клетку, и поиск идёт глубже.
+// Лист — нумерация по клеткам; каноническая — лист с наименьшим сертификатом.
+// Два листа с равными сертификатами дают автоморфизм; ветви, которые переводят друг
+// в друга найденные автоморфизмы, оставляющие на месте уже выделенные вершины, не
+// обходятся. Худший случай экспоненциален — рассчитано на паттерны
+template <typename G>
+class CanonicalLabeler {
+private:
+    int n;
+    vector<int> labels;
+    vector<vector<pair<int, int>>> adjacency;   // (сосед, метка ребра)
+
+    vector<int> prefix;                 // выделенные вершины на пути от корня
+    vector<vector<int>> automorphisms;
+    vector<int> firstOrder, firstCertificate;
+    vector<int> bestOrder, bestCertificate;
+
+    int refine(vector<int>& colour) const;
+    vector<int> leafCertificate(const vector<int>& order) const;
+    void leaf(const vector<int>& colour);
+    bool sameOrbit(int v, const vector<int>& explored) const;
+    void search(vector<int> colour);
+
+public:
+    explicit CanonicalLabeler(const G& graph);
+    CanonicalForm run();
+};
+
+template <typename G>
+CanonicalLabeler<G>::CanonicalLabeler(const G& graph)
+    : n(graph.getVertexCount()), labels(n), adjacency(n) {
+    for (int v = 0; v < n; ++v) {
+        labels[v] = graph.getVertexLabel(v);
+        for (int w : graph.getNeighbors(v)) adjacency[v].push_back({w, graph.getEdgeLabel(v, w)});
+    }
+}
+
+// Новые номера клеток — ранги ключей (цвет, отсортированные пары (цвет соседа, метка
+// ребра)). Цвет идёт первым, так что клетки только делятся и сохраняют порядок, а сам
+// порядок зависит лишь от структуры. Возвращает число клеток
+template <typename G>
+int CanonicalLabeler<G>::refine(vector<int>& colour) const {
+    int cells = 1 + *max_element(colour.begin(), colour.end());
+    vector<vector<int>> keys(n);
+    vector<int> byKey(n);
+    vector<pair<int, int>> around;
+    while (cells < n) {
+        for (int v = 0; v < n; ++v) {
+            around.clear();
+            for (const auto& edge : adjacency[v]) around.push_back({colour[edge.first], edge.second});
+            sort(around.begin(), around.end());
+            vector<int>& key = keys[v];
+            key.assign(1, colour[v]);
+            for (const auto& item : around) {
+                key.push_back(item.first);
+                key.push_back(item.second);
+            }
+            byKey[v] = v;
+        }
+        sort(byKey.begin(), byKey.end(), [&](int a, int b) { return keys[a] < keys[b]; });
+        int split = 0;
+        for (int i = 0; i < n; ++i) {
+            if (i > 0 && keys[byKey[i]] != keys[byKey[i - 1]]) split++;
+            colour[byKey[i]] = split;
+        }
+        if (split + 1 == cells) break;
+        cells = split + 1;
+    }
+    return cells;
+}
+
+// Число вершин, метки по порядку, затем для каждой вершины — число соседей с большим
+// номером и пары (номер, метка ребра) по возрастанию
+template <typename G>
+vector<int> CanonicalLabeler<G>::leafCertificate(const vector<int>& order) const {
+    vector<int> position = inversePermutation(order);
+    vector<int> certificate(1, n);
+    for (int i = 0; i < n; ++i) certificate.push_back(labels[order[i]]);
+    vector<pair<int, int>> later;
+    for (int i = 0; i < n; ++i) {
+        later.clear();
+        for (const auto& edge : adjacency[order[i]]) {
+            if (position[edge.first] > i) later.push_back({position[edge.first], edge.second});
+        }
+        sort(later.begin(), later.end());
+        certificate.push_back((int)later.size());
+        for (const auto& item : later) {
+            certificate.push_back(item.first);
+            certificate.push_back(item.second);
+        }
+    }
+    return certificate;
+}
+
+template <typename G>
+void CanonicalLabeler<G>::leaf(const vector<int>& colour) {
+    vector<int> order(n);
+    for (int v = 0; v < n; ++v) order[colour[v]] = v;
+    vector<int> certificate = leafCertificate(order);
+    if (firstOrder.empty()) {
+        firstOrder = bestOrder = order;
+        firstCertificate = bestCertificate = certificate;
+        return;
+    }
+    const vector<int>* twin = nullptr;
+    if (certificate == firstCertificate) {
+        twin = &firstOrder;
+    } else if (certificate == bestCertificate) {
+        twin = &bestOrder;
+    }
+    if (twin != nullptr) {
+        vector<int> automorphism(n);
+        for (int i = 0; i < n; ++i) automorphism[(*twin)[i]] = order[i];
+        automorphisms.push_back(move(automorphism));
+    } else if (certificate < bestCertificate) {
+        bestOrder = move(order);
+        bestCertificate = move(certificate);
+    }
+}
+
+// Орбиты группы, порождённой найденными автоморфизмами, которые не сдвигают prefix
+template <typename G>
+bool CanonicalLabeler<G>::sameOrbit(int v, const vector<int>& explored) const {
+    vector<int> parent(n);
+    for (int u = 0; u < n; ++u) parent[u] = u;
+    auto root = [&](int u) {
+        while (parent[u] != u) u = parent[u] = parent[parent[u]];
+        return u;
+    };
+    for (const vector<int>& automorphism : automorphisms) {
+        bool fixes = true;
+        for (int u : prefix) fixes = fixes && automorphism[u] == u;
+        if (!fixes) continue;
+        for (int u = 0; u < n; ++u) parent[root(u)] = root(automorphism[u]);
+    }
+    for (int u : explored) {
+        if (root(u) == root(v)) return true;
+    }
+    return false;
+}
+
+template <typename G>
+void CanonicalLabeler<G>::search(vector<int> colour) {
+    int cells = refine(colour);
+    if (cells == n) {
+        leaf(colour);
+        return;
+    }
+    vector<int> sizes(cells, 0);
+    for (int v = 0; v < n; ++v) sizes[colour[v]]++;
+    int target = -1;
+    for (int c = 0; c < cells; ++c) {
+        if (sizes[c] > 1 && (target < 0 || sizes[c] < sizes[target])) target = c;
+    }
+    vector<int> explored;
+    vector<int> child(n);
+    for (int v = 0; v < n; ++v) {
+        if (colour[v] != target || sameOrbit(v, explored)) continue;
+        explored.push_back(v);
+        // v остаётся в клетке target, остальные её вершины — в новой клетке сразу за ней
+        for (int u = 0; u < n; ++u) {
+            child[u] = colour[u] + (colour[u] > target || (colour[u] == target && u != v));
+        }
+        prefix.push_back(v);
+        search(child);
+        prefix.pop_back();
+    }
+}
+
+template <typename G>
+CanonicalForm CanonicalLabeler<G>::run() {
+    CanonicalForm form;
+    if (n > 0) {
+        // Начальные клетки — по метке и степени
+        vector<pair<int, int>> initial(n);
+        for (int v = 0; v < n; ++v) initial[v] = {labels[v], (int)adjacency[v].size()};
+        vector<pair<int, int>> distinct = initial;
+        sort(distinct.begin(), distinct.end());
+        distinct.erase(unique(distinct.begin(), distinct.end()), distinct.end());
+        vector<int> colour(n);
+        for (int v = 0; v < n; ++v) {
+            colour[v] = (int)(lower_bound(distinct.begin(), distinct.end(), initial[v]) - distinct.begin());
+        }
+        search(colour);
+        form.order = bestOrder;
+    } else {
+        bestCertificate = leafCertificate(form.order);
+    }
+    form.position = inversePermutation(form.order);
+    // Числа — по 4 байта, младший первым
+    for (int value : bestCertificate) {
+        for (int shift = 0; shift < 32; shift += 8) form.certificate.push_back((char)((uint32_t)value >> shift));
+    }
+    form.hash = certificateHash(form.certificate);
+    return form;
+}
+
+template <typename G>
+CanonicalForm buildCanonicalForm(const G& graph) {
+    return CanonicalLabeler<G>(graph).run();
+}
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef GRAPH_GENERATORS_H
+#define GRAPH_GENERATORS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "Thread_pool.h"
+
+using namespace std;
+
+// Генераторы случайных графов. Все принимают зерно и возвращают список рёбер
+// без повторов и петель; граф строится из него как Graph(edges, n) или CsrGraph(n, edges)
+
+// splitmix64: близкие зёрна дают независимые последовательности
+inline uint64_t mixSeed(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Первая строка r, под которой лежит не меньше pairs пар (w < v для v < r): r(r - 1) / 2 >= pairs
+inline int64_t gnpRowForPairs(int64_t pairs) {
+    int64_t r = (int64_t)ceil((1 + sqrt(1 + 8.0 * (double)pairs)) / 2);
+    while (r > 1 && (r - 1) * (r - 2) / 2 >= pairs) --r;
+    while (r * (r - 1) / 2 < pairs) ++r;
+    return r;
+}
+
+// Пары (w, v), w < v, для строк v из [rowFrom, rowTo): пропуски между рёбрами
+// геометрические, поэтому на каждое ребро тратится одно случайное число
+inline void sampleGnpRows(int rowFrom, int rowTo, double p, uint64_t seed, vector<pair<int, int>>& edges) {
+    mt19937_64 gen(seed);
+    uniform_real_distribution<double> dis(0.0, 1.0);
+    double logQ = log1p(-p);
+    int64_t v = max(rowFrom, 1);
+    int64_t w = -1;
+    while (v < rowTo) {
+        double skip = floor(log1p(-dis(gen)) / logQ);
+        if (skip >= (double)rowTo * rowTo) break;
+        w += 1 + (int64_t)skip;
+        while (w >= v && v < rowTo) {
+            w -= v;
+            ++v;
+        }
+        if (v < rowTo) edges.push_back({(int)w, (int)v});
+    }
+}
+
+// G(n, p) за O(n + m). Пары делятся на блоки строк с собственными потоками случайных
+// чисел; разбиение зависит только от n, поэтому результат не зависит от threads (0 — по числу ядер)
+inline vector<pair<int, int>> randomGnp(int n, double p, uint64_t seed, int threads = 0) {
+    vector<pair<int, int>> edges;
+    if (n < 2 || p <= 0) return edges;
+    if (p >= 1) {
+        edges.reserve((size_t)n * (n - 1) / 2);
+        for (int v = 1; v < n; ++v)
+            for (int w = 0; w < v; ++w) edges.push_back({w, v});
+        return edges;
+    }
+
+    const int64_t totalPairs = (int64_t)n * (n - 1) / 2;
+    const int blockCount = (int)min<int64_t>(n - 1, 256);
+    vector<int> rows(1, 1);
+    for (int b = 1; b < blockCount; ++b) {
+        int row = (int)gnpRowForPairs(totalPairs / blockCount * b);
+        if (row > rows.back() && row < n) rows.push_back(row);
+    }
+    rows.push_back(n);
+    int blocks = (int)rows.size() - 1;
+
+    vector<vector<pair<int, int>>> parts(blocks);
+    auto sampleBlock = [&](int b) {
+        int64_t pairs = (int64_t)rows[b + 1] * (rows[b + 1] - 1) / 2 - (int64_t)rows[b] * (rows[b] - 1) / 2;
+        parts[b].reserve((size_t)(pairs * p * 1.1) + 16);
+        sampleGnpRows(rows[b], rows[b + 1], p, mixSeed(seed ^ mixSeed(b + 1)), parts[b]);
+    };
+
+    if (threads <= 0) threads = (int)thread::hardware_concurrency();
+    threads = max(1, min(threads, blocks));
+    if (threads == 1) {
+        for (int b = 0; b < blocks; ++b) sampleBlock(b);
+    } else {
+        WorkStealingPool pool(threads);
+        for (int b = 0; b < blocks; ++b) {
+            pool.submit([&, b](int) { sampleBlock(b); });
+        }
+        pool.wait();
+    }
+
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    edges.reserve(total);
+    for (auto& part : parts) {
+        edges.insert(edges.end(), part.begin(), part.end());
+        vector<pair<int, int>>().swap(part);
+    }
+    return edges;
+}
+
+// G(n, m): ровно m различных рёбер, равновероятно среди всех таких графов.
+// Больше половины пар — выбирается дополнение
+inline vector<pair<int, int>> randomGnm(int n, int64_t m, uint64_t seed) {
+    vector<pair<int, int>> edges;
+    int64_t totalPairs = n < 2 ? 0 : (int64_t)n * (n - 1) / 2;
+    m = max<int64_t>(0, min(m, totalPairs));
+    bool complement = m > totalPairs / 2;
+    int64_t picks = complement ? totalPairs - m : m;
+
+    mt19937_64 gen(seed);
+    uniform_int_distribution<int> vertex(0, max(n - 1, 0));
+    unordered_set<uint64_t> chosen;
+    chosen.reserve((size_t)picks * 2);
+    while ((int64_t)chosen.size() < picks) {
+        int u = vertex(gen);
+        int v = vertex(gen);
+        if (u == v) continue;
+        if (u > v) swap(u, v);
+        chosen.insert((uint64_t)u << 32 | (uint32_t)v);
+    }
+
+    edges.reserve((size_t)m);
+    if (!complement) {
+        for (uint64_t key : chosen) edges.push_back({(int)(key >> 32), (int)(uint32_t)key});
+        sort(edges.begin(), edges.end());
+    } else {
+        for (int u = 0; u < n; ++u)
+            for (int v = u + 1; v < n; ++v)
+                if (!chosen.count((uint64_t)u << 32 | (uint32_t)v)) edges.push_back({u, v});
+    }
+    return edges;
+}
+
+// Барабаши — Альберт: начальная звезда из m + 1 вершин, каждая следующая вершина
+// присоединяется к m различным вершинам с вероятностью, пропорциональной степени.
+// При m < 1 или m >= n граф пуст
+inline vector<pair<int, int>> randomBarabasiAlbert(int n, int m, uint64_t seed) {
+    vector<pair<int, int>> edges;
+    if (m < 1 || m >= n) return edges;
+    edges.reserve((size_t)m * (n - m));
+
+    // Каждая вершина встречается в repeated столько раз, какова её степень
+    vector<int> repeated;
+    repeated.reserve((size_t)2 * m * (n - m));
+    for (int v = 1; v <= m; ++v) {
+        edges.push_back({0, v});
+        repeated.push_back(0);
+        repeated.push_back(v);
+    }
+
+    mt19937_64 gen(seed);
+    vector<int> targets;
+    for (int source = m + 1; source < n; ++source) {
+        targets.clear();
+        uniform_int_distribution<size_t> pick(0, repeated.size() - 1);
+        while ((int)targets.size() < m) {
+            int target = repeated[pick(gen)];
+            if (find(targets.begin(), targets.end(), target) == targets.end()) targets.push_back(target);
+        }
+        for (int target : targets) {
+            edges.push_back({target, source});
+            repeated.push_back(target);
+            repeated.push_back(source);
+        }
+    }
+    return edges;
+}
+
+// Случайный d-регулярный граф: случайное паросочетание «полурёбер», неудачные пары
+// перемешиваются заново; если оставшиеся пары не соединить, попытка начинается сначала.
+// При нечётном n * d, d >= n или исчерпании попыток граф пуст
+inline vector<pair<int, int>> randomRegular(int n, int d, uint64_t seed, int attempts = 1000) {
+    vector<pair<int, int>> edges;
+    if (d < 0 || d >= n || ((int64_t)n * d) % 2 != 0) return edges;
+    if (d == 0) return edges;
+
+    mt19937_64 gen(seed);
+    unordered_set<uint64_t> present;
+    vector<int> stubs;
+    vector<int> rejected;
+    for (int attempt = 0; attempt < attempts; ++attempt) {
+        edges.clear();
+        present.clear();
+        present.reserve((size_t)n * d);
+        stubs.clear();
+        for (int v = 0; v < n; ++v)
+            for (int i = 0; i < d; ++i) stubs.push_back(v);
+
+        bool stuck = false;
+        while (!stubs.empty() && !stuck) {
+            shuffle(stubs.begin(), stubs.end(), gen);
+            rejected.clear();
+            for (size_t i = 0; i + 1 < stubs.size(); i += 2) {
+                int u = min(stubs[i], stubs[i + 1]);
+                int v = max(stubs[i], stubs[i + 1]);
+                uint64_t key = (uint64_t)u << 32 | (uint32_t)v;
+                if (u != v && present.insert(key).second) {
+                    edges.push_back({u, v});
+                } else {
+                    rejected.push_back(u);
+                    rejected.push_back(v);
+                }
+            }
+            // Продолжать есть смысл, только если среди оставшихся есть допустимая пара
+            stuck = !rejected.empty();
+            for (size_t i = 0; i < rejected.size() && stuck; ++i) {
+                for (size_t j = i + 1; j < rejected.size() && stuck; ++j) {
+                    int u = min(rejected[i], rejected[j]);
+                    int v = max(rejected[i], rejected[j]);
+                    if (u != v && !present.count((uint64_t)u << 32 | (uint32_t)v)) stuck = false;
+                }
+            }
+            stubs.swap(rejected);
+        }
+        if (!stuck) return edges;
+    }
+    edges.clear();
+    return edges;
+}
+
+// Вставка copies непересекающихся копий паттерна в граф: для каждой копии выбираются
+// случайные вершины, и подграф на них заменяется паттерном (индуцированно).
+// Возвращает сопоставления вставленных копий — известная часть ответа для проверок.
+// Если вершин не хватает, вставляется столько копий, сколько помещается
+template <typename Pattern>
+vector<vector<int>> plantPattern(int vertices, vector<pair<int, int>>& edges, const Pattern& pattern,
+                                 int copies, uint64_t seed) {
+    int k = pattern.getVertexCount();
+    vector<vector<int>> planted;
+    if (k == 0 || copies <= 0) return planted;
+    copies = min(copies, vertices / k);
+
+    // Частичное перемешивание: первые copies * k вершин — случайная выборка
+    mt19937_64 gen(seed);
+    vector<int> order(vertices);
+    for (int v = 0; v < vertices; ++v) order[v] = v;
+    vector<int> copyOf(vertices, -1);
+    for (int i = 0; i < copies * k; ++i) {
+        uniform_int_distribution<int> pick(i, vertices - 1);
+        swap(order[i], order[pick(gen)]);
+        copyOf[order[i]] = i / k;
+    }
+
+    edges.erase(remove_if(edges.begin(), edges.end(), [&](const pair<int, int>& edge) {
+                    return copyOf[edge.first] >= 0 && copyOf[edge.first] == copyOf[edge.second];
+                }),
+                edges.end());
+    for (int c = 0; c < copies; ++c) {
+        vector<int> mapping(order.begin() + (size_t)c * k, order.begin() + (size_t)(c + 1) * k);
+        for (int u = 0; u < k; ++u) {
+            for (int v : pattern.getNeighbors(u)) {
+                if (u < v) edges.push_back({mapping[u], mapping[v]});
+            }
+        }
+        planted.push_back(move(mapping));
+    }
+    return planted;
+}
+
+#endif
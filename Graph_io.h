@@ -0,0 +1,666 @@
+#ifndef GRAPH_IO_H
+#define GRAPH_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Graph.h"
+#include "Csr_graph.h"
+#include "Thread_pool.h"
+
+using namespace std;
+
+enum class GraphFormat {
+    Auto,       // по расширению (.col, .gr, .g6, .s6), иначе по первым байтам файла
+    EdgeList,   // строки "u v [...]", номера с нуля; # и % — комментарии
+    Dimacs,     // "p edge n m" / "p sp n m", рёбра "e u v" или дуги "a u v w", номера с единицы
+    Graph6,
+    Sparse6
+};
+
+struct GraphLoadOptions {
+    GraphFormat format = GraphFormat::Auto;
+    int threads = 0;            // 0 — по числу ядер
+    bool compactIds = false;    // номера списка рёбер сжимаются в 0..n-1 с сохранением порядка
+};
+
+// Файл, отображённый в память только для чтения; без mmap читается целиком
+class MappedFile {
+private:
+    const char* ptr;
+    size_t length;
+#ifdef _WIN32
+    vector<char> buffer;
+#endif
+
+public:
+    MappedFile() : ptr(nullptr), length(0) {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // sequential — подсказка системе о последовательном чтении
+    bool open(const string& filename, bool sequential = true);
+    void close();
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+};
+
+inline bool MappedFile::open(const string& filename, bool sequential) {
+    close();
+#ifdef _WIN32
+    ifstream in(filename, ios::binary | ios::ate);
+    if (!in.is_open()) return false;
+    buffer.resize((size_t)in.tellg());
+    in.seekg(0);
+    if (!buffer.empty() && !in.read(buffer.data(), buffer.size())) return false;
+    ptr = buffer.data();
+    length = buffer.size();
+    return true;
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (info.st_size > 0) {
+        void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        madvise(mapped, (size_t)info.st_size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        ptr = static_cast<const char*>(mapped);
+        length = (size_t)info.st_size;
+    }
+    // Отображение остаётся действительным и после закрытия дескриптора
+    ::close(fd);
+    return true;
+#endif
+}
+
+inline void MappedFile::close() {
+#ifdef _WIN32
+    buffer.clear();
+    buffer.shrink_to_fit();
+#else
+    if (ptr) munmap(const_cast<char*>(ptr), length);
+#endif
+    ptr = nullptr;
+    length = 0;
+}
+
+// Рёбра одного куска файла; куски разбираются независимо и склеиваются по порядку
+struct EdgeChunk {
+    vector<pair<int, int>> edges;
+    int64_t maxId = -1;
+    int64_t declaredVertices = -1;  // из строки "p" в DIMACS
+    const char* errorAt = nullptr;
+    string error;
+};
+
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r')) ++p;
+    return p;
+}
+
+// Неотрицательное целое не больше INT32_MAX; nullptr — не число
+inline const char* parseId(const char* p, const char* end, int64_t& value) {
+    p = skipBlanks(p, end);
+    if (p == end || *p < '0' || *p > '9') return nullptr;
+    int64_t x = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        x = x * 10 + (*p - '0');
+        if (x > INT32_MAX) return nullptr;
+        ++p;
+    }
+    if (p < end && *p != ' ' && *p != '\t' && *p != ',' && *p != '\r' && *p != '\n') return nullptr;
+    value = x;
+    return p;
+}
+
+// Разбор строк [begin, end) списка рёбер или DIMACS; кусок всегда начинается с начала строки
+inline void parseEdgeLines(const char* begin, const char* end, bool dimacs, EdgeChunk& chunk) {
+    const char* p = begin;
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+        const char* line = p;
+        p = skipBlanks(p, lineEnd);
+
+        if (p < lineEnd && *p != '#' && *p != '%') {
+            int64_t u = 0;
+            int64_t v = 0;
+            bool edge = true;
+            if (dimacs) {
+                char tag = *p++;
+                if (tag == 'c') {
+                    edge = false;
+                } else if (tag == 'p') {
+                    // "p edge n m": слово формата пропускается
+                    p = skipBlanks(p, lineEnd);
+                    while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
+                    int64_t n = 0;
+                    if (!parseId(p, lineEnd, n)) {
+                        chunk.errorAt = line;
+                        chunk.error = "неверная строка p";
+                        return;
+                    }
+                    chunk.declaredVertices = n;
+                    edge = false;
+                } else if (tag != 'e' && tag != 'a') {
+                    chunk.errorAt = line;
+                    chunk.error = string("неизвестная строка '") + tag + "'";
+                    return;
+                }
+            }
+            if (edge) {
+                const char* q = parseId(p, lineEnd, u);
+                q = q ? parseId(q, lineEnd, v) : nullptr;
+                if (!q || (dimacs && (u == 0 || v == 0))) {
+                    chunk.errorAt = line;
+                    chunk.error = "ожидалась пара номеров вершин";
+                    return;
+                }
+                if (dimacs) {
+                    --u;
+                    --v;
+                }
+                chunk.edges.push_back({(int)u, (int)v});
+                chunk.maxId = max(chunk.maxId, max(u, v));
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+inline int loaderThreads(const GraphLoadOptions& options, size_t bytes) {
+    int threads = options.threads > 0 ? options.threads : (int)thread::hardware_concurrency();
+    // Меньше мегабайта на поток не окупает запуск потоков
+    int64_t byBytes = (int64_t)(bytes >> 20);
+    return (int)max<int64_t>(1, min<int64_t>(max(threads, 1), byBytes));
+}
+
+inline void setLoadError(string* error, const string& message) {
+    if (error) *error = message;
+}
+
+inline bool loadEdgeLines(const MappedFile& file, bool dimacs, const GraphLoadOptions& options,
+                          int& vertices, vector<pair<int, int>>& edges, string* error) {
+    const char* data = file.data();
+    const char* end = data + file.size();
+    int threads = loaderThreads(options, file.size());
+
+    // Границы кусков сдвигаются на начало следующей строки
+    vector<const char*> bounds(1, data);
+    for (int i = 1; i < threads; ++i) {
+        const char* at = data + file.size() / threads * i;
+        const char* newline = at < end ? static_cast<const char*>(memchr(at, '\n', end - at)) : nullptr;
+        bounds.push_back(max(newline ? newline + 1 : end, bounds.back()));
+    }
+    bounds.push_back(end);
+
+    vector<EdgeChunk> chunks(threads);
+    if (threads == 1) {
+        parseEdgeLines(data, end, dimacs, chunks[0]);
+    } else {
+        WorkStealingPool pool(threads);
+        for (int i = 0; i < threads; ++i) {
+            pool.submit([&, i](int) { parseEdgeLines(bounds[i], bounds[i + 1], dimacs, chunks[i]); });
+        }
+        pool.wait();
+    }
+
+    size_t total = 0;
+    int64_t maxId = -1;
+    int64_t declared = -1;
+    for (const EdgeChunk& chunk : chunks) {
+        if (chunk.errorAt) {
+            int64_t line = 1 + count(data, chunk.errorAt, '\n');
+            setLoadError(error, "строка " + to_string(line) + ": " + chunk.error);
+            return false;
+        }
+        total += chunk.edges.size();
+        maxId = max(maxId, chunk.maxId);
+        if (chunk.declaredVertices >= 0) declared = chunk.declaredVertices;
+    }
+
+    edges.clear();
+    edges.reserve(total);
+    for (EdgeChunk& chunk : chunks) {
+        edges.insert(edges.end(), chunk.edges.begin(), chunk.edges.end());
+        vector<pair<int, int>>().swap(chunk.edges);
+    }
+
+    if (dimacs && declared >= 0) {
+        if (maxId >= declared) {
+            setLoadError(error, "номер вершины " + to_string(maxId + 1) + " больше заявленных " + to_string(declared));
+            return false;
+        }
+        vertices = (int)declared;
+        return true;
+    }
+
+    if (!dimacs && options.compactIds) {
+        vector<int> ids;
+        ids.reserve(edges.size() * 2);
+        for (const auto& edge : edges) {
+            ids.push_back(edge.first);
+            ids.push_back(edge.second);
+        }
+        sort(ids.begin(), ids.end());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+        for (auto& edge : edges) {
+            edge.first = (int)(lower_bound(ids.begin(), ids.end(), edge.first) - ids.begin());
+            edge.second = (int)(lower_bound(ids.begin(), ids.end(), edge.second) - ids.begin());
+        }
+        vertices = (int)ids.size();
+        return true;
+    }
+
+    if (maxId >= INT32_MAX) {
+        setLoadError(error, "слишком большой номер вершины");
+        return false;
+    }
+    vertices = (int)(maxId + 1);
+    return true;
+}
+
+// Размер графа N(n) в graph6/sparse6: один, четыре или восемь байт
+inline const char* parseGraph6Size(const char* p, const char* end, int64_t& n) {
+    if (p == end || *p < 63 || *p > 126) return nullptr;
+    if (*p != 126) {
+        n = *p - 63;
+        return p + 1;
+    }
+    ++p;
+    int digits = 3;
+    if (p < end && *p == 126) {
+        ++p;
+        digits = 6;
+    }
+    if (end - p < digits) return nullptr;
+    n = 0;
+    for (int i = 0; i < digits; ++i) {
+        if (p[i] < 63 || p[i] > 126) return nullptr;
+        n = n << 6 | (p[i] - 63);
+    }
+    return p + digits;
+}
+
+// Первый граф файла graph6: верхний треугольник матрицы по столбцам, по 6 бит в байте
+inline bool loadGraph6(const char* p, const char* end, int& vertices,
+                       vector<pair<int, int>>& edges, string* error) {
+    int64_t n = 0;
+    p = parseGraph6Size(p, end, n);
+    if (!p || n > INT32_MAX) {
+        setLoadError(error, "неверный размер графа graph6");
+        return false;
+    }
+    int64_t bits = n * (n - 1) / 2;
+    if (end - p < (bits + 5) / 6) {
+        setLoadError(error, "файл graph6 обрезан");
+        return false;
+    }
+    for (const char* q = p; q < end; ++q) {
+        if (*q < 63 || *q > 126) {
+            setLoadError(error, "файл graph6 повреждён");
+            return false;
+        }
+    }
+    vertices = (int)n;
+    edges.clear();
+    int64_t k = 0;
+    for (int64_t j = 1; j < n; ++j) {
+        for (int64_t i = 0; i < j; ++i, ++k) {
+            int byte = p[k / 6] - 63;
+            if ((byte >> (5 - k % 6)) & 1) {
+                edges.push_back({(int)i, (int)j});
+            }
+        }
+    }
+    return true;
+}
+
+// Первый граф файла sparse6: поток пар (b, x), b — переход к следующей вершине
+inline bool loadSparse6(const char* p, const char* end, int& vertices,
+                        vector<pair<int, int>>& edges, string* error) {
+    if (p < end && *p == ';') {
+        setLoadError(error, "инкрементальный sparse6 не поддерживается");
+        return false;
+    }
+    if (p == end || *p != ':') {
+        setLoadError(error, "неверный заголовок sparse6");
+        return false;
+    }
+    ++p;
+    int64_t n = 0;
+    p = parseGraph6Size(p, end, n);
+    if (!p || n > INT32_MAX) {
+        setLoadError(error, "неверный размер графа sparse6");
+        return false;
+    }
+    vertices = (int)n;
+    edges.clear();
+
+    int k = 1;
+    while (((int64_t)1 << k) < n) ++k;
+
+    for (const char* q = p; q < end; ++q) {
+        if (*q < 63 || *q > 126) {
+            setLoadError(error, "файл sparse6 повреждён");
+            return false;
+        }
+    }
+    int64_t totalBits = (end - p) * 6;
+    int64_t position = 0;
+    auto readBits = [&](int count) {
+        int64_t value = 0;
+        for (int i = 0; i < count; ++i, ++position) {
+            int byte = p[position / 6] - 63;
+            value = value << 1 | ((byte >> (5 - position % 6)) & 1);
+        }
+        return value;
+    };
+
+    int64_t v = 0;
+    while (totalBits - position >= 1 + k) {
+        int64_t b = readBits(1);
+        int64_t x = readBits(k);
+        if (b) ++v;
+        // Хвост последнего байта заполнен единицами и выходит за n
+        if (x >= n || v >= n) break;
+        if (x > v) {
+            v = x;
+        } else {
+            edges.push_back({(int)x, (int)v});
+        }
+    }
+    return true;
+}
+
+inline GraphFormat detectGraphFormat(const string& filename, const MappedFile& file) {
+    size_t dot = filename.rfind('.');
+    string extension = dot == string::npos ? "" : filename.substr(dot + 1);
+    if (extension == "col" || extension == "gr" || extension == "dimacs") return GraphFormat::Dimacs;
+    if (extension == "g6") return GraphFormat::Graph6;
+    if (extension == "s6") return GraphFormat::Sparse6;
+
+    const char* p = file.data();
+    size_t size = file.size();
+    if (size >= 11 && memcmp(p, ">>sparse6<<", 11) == 0) return GraphFormat::Sparse6;
+    if (size >= 10 && memcmp(p, ">>graph6<<", 10) == 0) return GraphFormat::Graph6;
+    if (size >= 1 && (p[0] == ':' || p[0] == ';')) return GraphFormat::Sparse6;
+    if (size >= 2 && (p[0] == 'c' || p[0] == 'p') && (p[1] == ' ' || p[1] == '\n')) return GraphFormat::Dimacs;
+    return GraphFormat::EdgeList;
+}
+
+// Чтение файла в список рёбер; повторы и петли отбрасывает построение графа
+inline bool loadGraphEdges(const string& filename, const GraphLoadOptions& options,
+                           int& vertices, vector<pair<int, int>>& edges, string* error = nullptr) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        setLoadError(error, "не удалось открыть " + filename);
+        return false;
+    }
+    GraphFormat format = options.format == GraphFormat::Auto ? detectGraphFormat(filename, file) : options.format;
+
+    const char* p = file.data();
+    const char* end = p + file.size();
+    if (format == GraphFormat::Graph6 || format == GraphFormat::Sparse6) {
+        const char* header = format == GraphFormat::Graph6 ? ">>graph6<<" : ">>sparse6<<";
+        size_t headerLength = strlen(header);
+        if (file.size() >= headerLength && memcmp(p, header, headerLength) == 0) p += headerLength;
+        const char* newline = p < end ? static_cast<const char*>(memchr(p, '\n', end - p)) : nullptr;
+        if (newline) end = newline;
+        if (end > p && end[-1] == '\r') --end;
+        return format == GraphFormat::Graph6 ? loadGraph6(p, end, vertices, edges, error)
+                                             : loadSparse6(p, end, vertices, edges, error);
+    }
+    return loadEdgeLines(file, format == GraphFormat::Dimacs, options, vertices, edges, error);
+}
+
+// Загрузка большого графа: список рёбер сразу раскладывается в CSR
+inline bool loadGraphFile(const string& filename, CsrGraph& graph,
+                          const GraphLoadOptions& options = GraphLoadOptions(), string* error = nullptr) {
+    int vertices = 0;
+    vector<pair<int, int>> edges;
+    if (!loadGraphEdges(filename, options, vertices, edges, error)) return false;
+    graph = CsrGraph(vertices, edges);
+    return true;
+}
+
+// Загрузка в Graph; повторы удаляются через CSR, матрица смежности строится один раз
+inline bool loadGraphFile(const string& filename, Graph& graph,
+                          const GraphLoadOptions& options = GraphLoadOptions(), string* error = nullptr) {
+    CsrGraph csr;
+    if (!loadGraphFile(filename, csr, options, error)) return false;
+    vector<pair<int, int>> edges;
+    edges.reserve(csr.getEdgeCount());
+    for (int u = 0; u < csr.getVertexCount(); ++u) {
+        for (int v : csr.getNeighbors(u)) {
+            if (u < v) edges.push_back({u, v});
+        }
+    }
+    graph = Graph(edges, csr.getVertexCount());
+    return true;
+}
+
+// Двоичный снимок CSR-графа. Заголовок 64 байта, затем секции, каждая с границы 64 байт:
+// offsets (int64, V + 1), neighbors (int32, 2E), degrees (int32, V),
+// необязательные метки вершин (int32, V) и рёбер (int32, 2E, параллельно neighbors).
+// Числа записаны в порядке байт машины, порядок проверяется по endianTag
+const char SNAPSHOT_MAGIC[8] = {'C', 'S', 'R', 'G', 'R', 'A', 'P', 'H'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_ENDIAN_TAG = 0x01020304;
+const uint32_t SNAPSHOT_VERTEX_LABELS = 1;
+const uint32_t SNAPSHOT_EDGE_LABELS = 2;
+const size_t SNAPSHOT_ALIGN = 64;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t vertices;
+    uint64_t neighborCount;     // 2E
+    uint64_t payloadBytes;
+    uint64_t payloadChecksum;   // по всем секциям вместе с выравниванием
+    uint64_t headerChecksum;    // по предыдущим полям заголовка
+};
+static_assert(sizeof(SnapshotHeader) == SNAPSHOT_ALIGN, "заголовок снимка занимает 64 байта");
+
+// Контрольная сумма по 64-битным словам; длина кратна 8
+inline uint64_t snapshotChecksum(const void* data, size_t bytes, uint64_t seed = 0) {
+    const uint64_t* words = static_cast<const uint64_t*>(data);
+    uint64_t h = seed ^ 0x9e3779b97f4a7c15ull;
+    for (size_t i = 0; i < bytes / 8; ++i) {
+        h ^= words[i] * 0xbf58476d1ce4e5b9ull;
+        h = (h << 31 | h >> 33) * 0x94d049bb133111ebull;
+    }
+    return h ^ (h >> 29);
+}
+
+inline size_t snapshotAligned(size_t bytes) {
+    return (bytes + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+}
+
+// Смещения секций от начала данных после заголовка
+struct SnapshotLayout {
+    size_t offsets, neighbors, degrees, vertexLabels, edgeLabels, total;
+
+    SnapshotLayout(uint64_t vertices, uint64_t neighborCount, uint32_t flags) {
+        offsets = 0;
+        neighbors = offsets + snapshotAligned((vertices + 1) * sizeof(int64_t));
+        degrees = neighbors + snapshotAligned(neighborCount * sizeof(int));
+        vertexLabels = degrees + snapshotAligned(vertices * sizeof(int));
+        edgeLabels = vertexLabels + (flags & SNAPSHOT_VERTEX_LABELS ? snapshotAligned(vertices * sizeof(int)) : 0);
+        total = edgeLabels + (flags & SNAPSHOT_EDGE_LABELS ? snapshotAligned(neighborCount * sizeof(int)) : 0);
+    }
+};
+
+inline bool saveGraphSnapshot(const string& filename, const CsrGraph& graph, string* error = nullptr) {
+    CsrArrays arrays = graph.getArrays();
+    uint64_t vertices = (uint64_t)arrays.vertices;
+    uint64_t neighborCount = (uint64_t)arrays.offsets[vertices];
+    uint32_t flags = (arrays.vertexLabels ? SNAPSHOT_VERTEX_LABELS : 0) |
+                     (arrays.edgeLabels ? SNAPSHOT_EDGE_LABELS : 0);
+    SnapshotLayout layout(vertices, neighborCount, flags);
+
+    // Секции пишутся блоками, сумма считается по тем же байтам, включая нули выравнивания
+    vector<pair<const void*, size_t>> sections = {
+        {arrays.offsets, (vertices + 1) * sizeof(int64_t)},
+        {arrays.neighbors, neighborCount * sizeof(int)},
+        {arrays.degrees, vertices * sizeof(int)}};
+    if (arrays.vertexLabels) sections.push_back({arrays.vertexLabels, vertices * sizeof(int)});
+    if (arrays.edgeLabels) sections.push_back({arrays.edgeLabels, neighborCount * sizeof(int)});
+
+    uint64_t checksum = 0;
+    vector<char> block;
+    const size_t blockBytes = (size_t)1 << 22;
+
+    ofstream out(filename, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        setLoadError(error, "не удалось создать " + filename);
+        return false;
+    }
+    SnapshotHeader header = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint64_t seed = 0;
+    for (const auto& section : sections) {
+        const char* bytes = static_cast<const char*>(section.first);
+        size_t padded = snapshotAligned(section.second);
+        for (size_t from = 0; from < padded; from += blockBytes) {
+            size_t length = min(blockBytes, padded - from);
+            block.assign(length, 0);
+            if (from < section.second) {
+                memcpy(block.data(), bytes + from, min(length, section.second - from));
+            }
+            checksum = snapshotChecksum(block.data(), length, checksum ^ seed++);
+            out.write(block.data(), length);
+        }
+    }
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.endianTag = SNAPSHOT_ENDIAN_TAG;
+    header.flags = flags;
+    header.vertices = vertices;
+    header.neighborCount = neighborCount;
+    header.payloadBytes = layout.total;
+    header.payloadChecksum = checksum;
+    header.headerChecksum = snapshotChecksum(&header, offsetof(SnapshotHeader, headerChecksum));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out) {
+        setLoadError(error, "ошибка записи " + filename);
+        return false;
+    }
+    return true;
+}
+
+inline bool saveGraphSnapshot(const string& filename, const Graph& graph, string* error = nullptr) {
+    return saveGraphSnapshot(filename, CsrGraph(graph), error);
+}
+
+// Проверка суммы по всем данным: читает весь файл, поэтому по умолчанию выключена
+inline uint64_t snapshotPayloadChecksum(const char* payload, const SnapshotHeader& header) {
+    SnapshotLayout layout(header.vertices, header.neighborCount, header.flags);
+    vector<size_t> bounds = {layout.neighbors, layout.degrees, layout.vertexLabels, layout.edgeLabels, layout.total};
+    bounds.erase(unique(bounds.begin(), bounds.end()), bounds.end());
+    const size_t blockBytes = (size_t)1 << 22;
+    uint64_t checksum = 0;
+    uint64_t seed = 0;
+    size_t from = 0;
+    for (size_t to : bounds) {
+        for (size_t at = from; at < to; at += blockBytes) {
+            size_t length = min(blockBytes, to - at);
+            checksum = snapshotChecksum(payload + at, length, checksum ^ seed++);
+        }
+        from = to;
+    }
+    return checksum;
+}
+
+// Открытие снимка без копирования: граф становится представлением над отображённым файлом
+// и держит отображение, пока жив он сам или его копии. Без verifyChecksum проверяются
+// только заголовок и крайние смещения: повреждённые данные дадут выход за границы при
+// поиске, так что непроверенное представление безопасно лишь для доверенных файлов
+inline bool loadGraphSnapshot(const string& filename, CsrGraph& graph, bool verifyChecksum = false,
+                              string* error = nullptr) {
+    auto file = make_shared<MappedFile>();
+    if (!file->open(filename, false)) {
+        setLoadError(error, "не удалось открыть " + filename);
+        return false;
+    }
+    if (file->size() < sizeof(SnapshotHeader)) {
+        setLoadError(error, "файл меньше заголовка снимка");
+        return false;
+    }
+    SnapshotHeader header;
+    memcpy(&header, file->data(), sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        setLoadError(error, "не снимок графа");
+        return false;
+    }
+    if (header.endianTag != SNAPSHOT_ENDIAN_TAG) {
+        setLoadError(error, "снимок записан с другим порядком байт");
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        setLoadError(error, "неподдерживаемая версия снимка " + to_string(header.version));
+        return false;
+    }
+    if (header.headerChecksum != snapshotChecksum(&header, offsetof(SnapshotHeader, headerChecksum)) ||
+        header.vertices > INT32_MAX) {
+        setLoadError(error, "заголовок снимка повреждён");
+        return false;
+    }
+    SnapshotLayout layout(header.vertices, header.neighborCount, header.flags);
+    if (header.payloadBytes != layout.total || file->size() < sizeof(header) + layout.total) {
+        setLoadError(error, "снимок обрезан");
+        return false;
+    }
+
+    const char* payload = file->data() + sizeof(header);
+    if (verifyChecksum && snapshotPayloadChecksum(payload, header) != header.payloadChecksum) {
+        setLoadError(error, "контрольная сумма снимка не совпадает");
+        return false;
+    }
+
+    CsrArrays arrays;
+    arrays.vertices = (int)header.vertices;
+    arrays.offsets = reinterpret_cast<const int64_t*>(payload + layout.offsets);
+    arrays.neighbors = reinterpret_cast<const int*>(payload + layout.neighbors);
+    arrays.degrees = reinterpret_cast<const int*>(payload + layout.degrees);
+    if (header.flags & SNAPSHOT_VERTEX_LABELS) {
+        arrays.vertexLabels = reinterpret_cast<const int*>(payload + layout.vertexLabels);
+    }
+    if (header.flags & SNAPSHOT_EDGE_LABELS) {
+        arrays.edgeLabels = reinterpret_cast<const int*>(payload + layout.edgeLabels);
+    }
+    if (arrays.offsets[0] != 0 || (uint64_t)arrays.offsets[arrays.vertices] != header.neighborCount) {
+        setLoadError(error, "смещения снимка повреждены");
+        return false;
+    }
+    graph = CsrGraph::view(arrays, file);
+    return true;
+}
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef GRAPH_REORDER_H
+#define GRAPH_REORDER_H
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <vector>
+
+using namespace std;
+
+// Перенумерация вершин для локальности: соседние в графе вершины получают близкие
+// номера, и их строки матрицы и списки смежности лежат рядом в памяти.
+// Все функции возвращают order: order[новый номер] = старый номер
+enum class VertexOrdering {
+    None,
+    DegreeDescending,       // по убыванию степени: частые кандидаты — в начале
+    ReverseCuthillMcKee,    // обход в ширину от вершины малой степени, в обратном порядке
+    Gorder                  // жадно: следующая вершина больше всех связана с последними window
+};
+
+inline vector<int> inversePermutation(const vector<int>& order) {
+    vector<int> inverse(order.size());
+    for (size_t i = 0; i < order.size(); ++i) inverse[order[i]] = (int)i;
+    return inverse;
+}
+
+template <typename G>
+vector<int> degreeOrder(const G& graph) {
+    vector<int> order(graph.getVertexCount());
+    for (int v = 0; v < (int)order.size(); ++v) order[v] = v;
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return graph.getDegree(a) > graph.getDegree(b); });
+    return order;
+}
+
+// Каждая компонента начинается с непосещённой вершины наименьшей степени, соседи
+// ставятся в очередь по возрастанию степени
+template <typename G>
+vector<int> rcmOrder(const G& graph) {
+    int n = graph.getVertexCount();
+    vector<int> byDegree(n);
+    for (int v = 0; v < n; ++v) byDegree[v] = v;
+    stable_sort(byDegree.begin(), byDegree.end(), [&](int a, int b) { return graph.getDegree(a) < graph.getDegree(b); });
+
+    vector<int> order;
+    order.reserve(n);
+    vector<char> visited(n, 0);
+    vector<int> neighbors;
+    for (int start : byDegree) {
+        if (visited[start]) continue;
+        visited[start] = 1;
+        size_t head = order.size();
+        order.push_back(start);
+        while (head < order.size()) {
+            int v = order[head++];
+            neighbors.clear();
+            for (int w : graph.getNeighbors(v)) {
+                if (!visited[w]) {
+                    visited[w] = 1;
+                    neighbors.push_back(w);
+                }
+            }
+            stable_sort(neighbors.begin(), neighbors.end(),
+                        [&](int a, int b) { return graph.getDegree(a) < graph.getDegree(b); });
+            order.insert(order.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+    reverse(order.begin(), order.end());
+    return order;
+}
+
+// Gorder (Wei и др., 2016) для неориентированного графа: оценка вершины — сумма по
+// последним window поставленным вершинам u числа общих соседей с u и смежности с u.
+// Оценки меняются на ±1 при входе u в окно и выходе из него, максимум берётся из кучи
+// с ленивым удалением устаревших записей. Через вершины степени больше hub общие соседи
+// не считаются: иначе каждый её сосед давал бы O(степень^2) обновлений
+template <typename G>
+vector<int> gorderOrder(const G& graph, int window = 5) {
+    int n = graph.getVertexCount();
+    int hub = max(32, (int)sqrt((double)n));
+    vector<int> score(n, 0);
+    vector<char> placed(n, 0);
+    priority_queue<pair<int, int>> heap;    // (оценка, вершина), устаревшие пропускаются
+
+    auto update = [&](int u, int delta) {
+        auto touch = [&](int x) {
+            if (placed[x]) return;
+            score[x] += delta;
+            if (score[x] > 0) heap.push({score[x], x});
+        };
+        for (int x : graph.getNeighbors(u)) {
+            touch(x);
+            if (graph.getDegree(x) > hub) continue;
+            for (int y : graph.getNeighbors(x)) {
+                if (y != u) touch(y);
+            }
+        }
+    };
+
+    // Новая область начинается с вершины наибольшей степени
+    vector<int> seeds = degreeOrder(graph);
+    size_t nextSeed = 0;
+    vector<int> order;
+    order.reserve(n);
+    while ((int)order.size() < n) {
+        int v = -1;
+        while (!heap.empty()) {
+            pair<int, int> top = heap.top();
+            heap.pop();
+            if (!placed[top.second] && score[top.second] == top.first) {
+                v = top.second;
+                break;
+            }
+        }
+        if (v < 0) {
+            while (placed[seeds[nextSeed]]) ++nextSeed;
+            v = seeds[nextSeed];
+        }
+        placed[v] = 1;
+        order.push_back(v);
+        update(v, 1);
+        if ((int)order.size() > window) update(order[order.size() - 1 - window], -1);
+    }
+    return order;
+}
+
+template <typename G>
+vector<int> vertexOrder(const G& graph, VertexOrdering ordering) {
+    switch (ordering) {
+        case VertexOrdering::DegreeDescending:
+            return degreeOrder(graph);
+        case VertexOrdering::ReverseCuthillMcKee:
+            return rcmOrder(graph);
+        case VertexOrdering::Gorder:
+            return gorderOrder(graph);
+        default: {
+            vector<int> order(graph.getVertexCount());
+            for (int v = 0; v < (int)order.size(); ++v) order[v] = v;
+            return order;
+        }
+    }
+}
+
+#endif
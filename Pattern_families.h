@@ -0,0 +1,264 @@
+#ifndef PATTERN_FAMILIES_H
+#define PATTERN_FAMILIES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+using namespace std;
+
+// Семейства паттернов, для которых вхождения перечисляются специальными алгоритмами
+// вместо общего перебора (см. SearchOptions::family)
+enum class PatternFamily {
+    Auto,       // определить по паттерну
+    General,    // общий движок
+    Clique,     // полный граф, от 2 вершин (ребро, треугольник, ...)
+    Path,       // простой путь, от 3 вершин
+    Cycle,      // простой цикл, от 4 вершин (цикл из 3 — клика)
+    Star        // центр и листья, от 4 вершин (звезда из 3 — путь)
+};
+
+// Семейство паттерна по его структуре; метки не учитываются
+template <typename G>
+PatternFamily detectPatternFamily(const G& pattern) {
+    int k = pattern.getVertexCount();
+    if (k < 2) return PatternFamily::General;
+
+    int64_t edges = 0;
+    int maxDegree = 0, minDegree = k;
+    for (int u = 0; u < k; ++u) {
+        edges += pattern.getDegree(u);
+        maxDegree = max(maxDegree, pattern.getDegree(u));
+        minDegree = min(minDegree, pattern.getDegree(u));
+    }
+    edges /= 2;
+    if (edges == (int64_t)k * (k - 1) / 2) return PatternFamily::Clique;
+
+    vector<char> seen(k, 0);
+    vector<int> queue(1, 0);
+    seen[0] = 1;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        for (int w : pattern.getNeighbors(queue[head])) {
+            if (!seen[w]) {
+                seen[w] = 1;
+                queue.push_back(w);
+            }
+        }
+    }
+    if ((int)queue.size() != k) return PatternFamily::General;
+
+    if (edges == k - 1 && maxDegree <= 2) return PatternFamily::Path;
+    if (edges == k - 1 && maxDegree == k - 1) return PatternFamily::Star;
+    if (edges == k && minDegree == 2 && maxDegree == 2) return PatternFamily::Cycle;
+    return PatternFamily::General;
+}
+
+// Смежность позиций i и j во вхождении семейства (раскладка — как у FamilyLister)
+inline bool familyLinked(PatternFamily family, int k, int i, int j) {
+    switch (family) {
+        case PatternFamily::Clique:
+            return i != j;
+        case PatternFamily::Path:
+            return i - j == 1 || j - i == 1;
+        case PatternFamily::Cycle:
+            return i - j == 1 || j - i == 1 || (min(i, j) == 0 && max(i, j) == k - 1);
+        case PatternFamily::Star:
+            return (i == 0) != (j == 0);
+        default:
+            return false;
+    }
+}
+
+// Рёбра, направленные от младшей вершины к старшей в порядке (степень, номер):
+// исходящих у каждой вершины O(√m), и каждая клика перечисляется один раз —
+// от своей младшей вершины. Списки исходящих отсортированы по номеру
+struct OrientedAdjacency {
+    vector<int64_t> offsets;
+    vector<int> targets;
+
+    const int* begin(int v) const { return targets.data() + offsets[v]; }
+    const int* end(int v) const { return targets.data() + offsets[v + 1]; }
+};
+
+template <typename G>
+OrientedAdjacency orientByDegree(const G& graph, const vector<char>& allowed) {
+    int n = graph.getVertexCount();
+    auto older = [&](int a, int b) {
+        int da = graph.getDegree(a), db = graph.getDegree(b);
+        return da != db ? da > db : a > b;
+    };
+    OrientedAdjacency dag;
+    dag.offsets.assign(n + 1, 0);
+    for (int v = 0; v < n; ++v) {
+        dag.offsets[v + 1] = dag.offsets[v];
+        if (!allowed[v]) continue;
+        for (int w : graph.getNeighbors(v)) {
+            if (allowed[w] && older(w, v)) {
+                dag.targets.push_back(w);
+                dag.offsets[v + 1]++;
+            }
+        }
+        sort(dag.targets.begin() + dag.offsets[v], dag.targets.end());
+    }
+    return dag;
+}
+
+// Перечисление вхождений одного семейства с заданным корнем. Вхождение — вершины графа
+// в раскладке семейства: клика — от младшей в порядке orientByDegree, путь — от конца
+// с меньшим номером, цикл — от наименьшей вершины к меньшему из двух её соседей по циклу,
+// звезда — центр, затем листья по возрастанию номера. Корень — первая вершина раскладки,
+// так что по всем корням каждое вхождение (подграф с точностью до симметрий семейства)
+// выдаётся ровно один раз.
+// induced — между несмежными в раскладке вершинами нет рёбер (для клики не важно).
+// emit(occurrence) и tick() возвращают false для остановки; tick вызывается на каждом шаге
+template <typename G>
+class FamilyLister {
+private:
+    const G* graph;
+    const vector<char>* allowed;
+    const OrientedAdjacency* dag;
+    PatternFamily family;
+    int k;
+    bool induced;
+
+    vector<int> occurrence;
+    vector<char> onPath;
+    vector<vector<int>> levels;     // общие старшие соседи выбранных вершин клики
+    vector<int> leaves;
+    vector<int> near;               // число соседей среди вершин, с которыми запрещены хорды
+    vector<int> rootMark;           // rootMark[x] == корень — x смежна с корнем (цикл) или исходящая (клика)
+
+    void touch(int y, int delta) {
+        for (int w : graph->getNeighbors(y)) near[w] += delta;
+    }
+
+    template <typename Emit, typename Tick>
+    bool cliques(int level, Emit& emit, Tick& tick) {
+        const vector<int>& candidates = levels[level];
+        if ((int)candidates.size() < k - level) return true;
+        for (int x : candidates) {
+            if (!tick()) return false;
+            occurrence[level] = x;
+            if (level + 1 == k) {
+                if (!emit(occurrence)) return false;
+                continue;
+            }
+            // Кандидаты первого уровня — все исходящие корня, они отмечены в rootMark
+            vector<int>& next = levels[level + 1];
+            next.clear();
+            if (level == 1) {
+                for (const int* y = dag->begin(x); y != dag->end(x); ++y) {
+                    if (rootMark[*y] == occurrence[0]) next.push_back(*y);
+                }
+            } else {
+                set_intersection(candidates.begin(), candidates.end(), dag->begin(x), dag->end(x),
+                                 back_inserter(next));
+            }
+            if (!cliques(level + 1, emit, tick)) return false;
+        }
+        return true;
+    }
+
+    // Путь и цикл: продолжение occurrence[0..i-1] соседом occurrence[i-1]. При induced
+    // near считает соседей среди occurrence[0..i-2] (у цикла — без корня, он отмечен в rootMark)
+    template <typename Emit, typename Tick>
+    bool walks(int i, Emit& emit, Tick& tick) {
+        bool cycle = family == PatternFamily::Cycle;
+        bool chords = induced && i >= (cycle ? 3 : 2);
+        if (chords) touch(occurrence[i - 2], 1);
+        bool proceed = extendWalk(i, cycle, emit, tick);
+        if (chords) touch(occurrence[i - 2], -1);
+        return proceed;
+    }
+
+    template <typename Emit, typename Tick>
+    bool extendWalk(int i, bool cycle, Emit& emit, Tick& tick) {
+        int root = occurrence[0];
+        bool last = i == k - 1;
+        for (int x : graph->getNeighbors(occurrence[i - 1])) {
+            if (!(*allowed)[x] || onPath[x] || (cycle && x < root)) continue;
+            if (!tick()) return false;
+            if (induced && near[x] != 0) continue;
+            if (cycle) {
+                bool closes = rootMark[x] == root;
+                if (last ? !closes || x < occurrence[1] : induced && i > 1 && closes) continue;
+            } else if (last && x < root) {
+                continue;
+            }
+            occurrence[i] = x;
+            if (last) {
+                if (!emit(occurrence)) return false;
+                continue;
+            }
+            onPath[x] = 1;
+            bool proceed = walks(i + 1, emit, tick);
+            onPath[x] = 0;
+            if (!proceed) return false;
+        }
+        return true;
+    }
+
+    // Листья звезды выбираются по возрастанию номера; при induced near
+    // считает соседей среди уже выбранных листьев
+    template <typename Emit, typename Tick>
+    bool stars(int i, size_t from, Emit& emit, Tick& tick) {
+        for (size_t j = from; j + (k - 1 - i) < leaves.size(); ++j) {
+            int x = leaves[j];
+            if (!tick()) return false;
+            if (induced && near[x] != 0) continue;
+            occurrence[i] = x;
+            if (i == k - 1) {
+                if (!emit(occurrence)) return false;
+                continue;
+            }
+            if (induced) touch(x, 1);
+            bool proceed = stars(i + 1, j + 1, emit, tick);
+            if (induced) touch(x, -1);
+            if (!proceed) return false;
+        }
+        return true;
+    }
+
+public:
+    FamilyLister(const G& targetGraph, PatternFamily patternFamily, int size, bool inducedOnly,
+                 const vector<char>& allowedVertices, const OrientedAdjacency* oriented)
+        : graph(&targetGraph), allowed(&allowedVertices), dag(oriented), family(patternFamily), k(size),
+          induced(inducedOnly), occurrence(size, -1), onPath(targetGraph.getVertexCount(), 0), levels(size),
+          near(inducedOnly ? targetGraph.getVertexCount() : 0, 0),
+          rootMark(patternFamily == PatternFamily::Cycle || patternFamily == PatternFamily::Clique
+                   ? targetGraph.getVertexCount() : 0, -1) {}
+
+    template <typename Emit, typename Tick>
+    bool listFrom(int root, Emit& emit, Tick& tick) {
+        if (!(*allowed)[root]) return true;
+        occurrence[0] = root;
+        switch (family) {
+            case PatternFamily::Clique:
+                levels[1].assign(dag->begin(root), dag->end(root));
+                for (int w : levels[1]) rootMark[w] = root;
+                return cliques(1, emit, tick);
+            case PatternFamily::Path:
+            case PatternFamily::Cycle: {
+                if (family == PatternFamily::Cycle) {
+                    for (int w : graph->getNeighbors(root)) rootMark[w] = root;
+                }
+                onPath[root] = 1;
+                bool proceed = walks(1, emit, tick);
+                onPath[root] = 0;
+                return proceed;
+            }
+            case PatternFamily::Star:
+                leaves.clear();
+                for (int w : graph->getNeighbors(root)) {
+                    if ((*allowed)[w]) leaves.push_back(w);
+                }
+                sort(leaves.begin(), leaves.end());
+                return stars(1, 0, emit, tick);
+            default:
+                return true;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef QUERY_CACHE_H
+#define QUERY_CACHE_H
+
+#include <cstdio>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "Graph.h"
+
+using namespace std;
+
+// Отпечаток содержимого графа. Версии графа живут в пределах процесса, поэтому
+// дисковый уровень кэша привязан к отпечатку; сумма по соседям не зависит от
+// порядка списков смежности
+inline uint64_t graphFingerprint(const Graph& graph) {
+    uint64_t h = mixSeed(graph.getVertexCount());
+    for (int v = 0; v < graph.getVertexCount(); ++v) {
+        uint64_t around = 0;
+        for (int w : graph.getNeighbors(v)) {
+            around += mixSeed((uint64_t)w << 32 | (uint32_t)graph.getEdgeLabel(v, w));
+        }
+        h = mixSeed(h ^ around ^ mixSeed((uint32_t)graph.getVertexLabel(v)));
+    }
+    return h;
+}
+
+struct QueryCacheStats {
+    uint64_t hits = 0;          // из памяти
+    uint64_t diskHits = 0;
+    uint64_t misses = 0;        // выполнен поиск
+};
+
+// Кэш результатов поиска сопоставлений. Ключ — версия целевого графа (Graph::getVersion),
+// сертификат паттерна (Graph::canonicalForm) и режим: семантика и снятие симметрии.
+// Паттерн с другой нумерацией вершин находит результат, посчитанный для любого изоморфного
+// ему: сопоставления хранятся в канонических номерах и переводятся в номера запроса через
+// его каноническую перестановку. Изменение графа меняет версию, и старые записи перестают
+// находиться, пока их не вытеснит LRU на capacity запросов.
+// Если задан directory, результаты пишутся и туда (ключ — отпечаток содержимого графа)
+// и переживают перезапуск. Результат отсортирован. При Break кэш отдаёт по одному
+// сопоставлению на класс, но не обязательно те, что выбрал бы поиск для этой нумерации.
+// Остановленный через SearchControl поиск не кэшируется. Потокобезопасен, поиск идёт без блокировки
+class QueryCache {
+private:
+    using Mappings = vector<vector<int>>;
+    struct Entry {
+        string key;
+        shared_ptr<const Mappings> mappings;    // в канонических номерах паттерна
+    };
+
+    size_t capacity;
+    string directory;
+    mutable mutex lock;
+    list<Entry> recent;         // от недавних к давним
+    unordered_map<string, list<Entry>::iterator> index;
+    uint64_t fingerprintVersion;
+    uint64_t fingerprint;
+    QueryCacheStats stats;
+
+    static string bytesOf(uint64_t value);
+    static string modeKey(const SearchOptions& options);
+    shared_ptr<const Mappings> recall(const string& key);
+    void remember(const string& key, shared_ptr<const Mappings> mappings);
+    uint64_t targetFingerprint(const Graph& target);
+    string diskPath(const string& diskKey) const;
+    shared_ptr<const Mappings> loadDisk(const string& diskKey, size_t patternSize) const;
+    void saveDisk(const string& diskKey, const Mappings& mappings) const;
+
+public:
+    explicit QueryCache(size_t entries = 64, const string& cacheDirectory = "");
+
+    vector<vector<int>> findIsomorphicSubgraph(const Graph& target, const Graph& pattern,
+                                               const SearchOptions& options = SearchOptions());
+
+    size_t size() const;
+    void clear();       // только память; файлы в directory остаются
+    QueryCacheStats getStats() const;
+};
+
+inline QueryCache::QueryCache(size_t entries, const string& cacheDirectory)
+    : capacity(max<size_t>(entries, 1)), directory(cacheDirectory), fingerprintVersion(0), fingerprint(0) {}
+
+inline string QueryCache::bytesOf(uint64_t value) {
+    string bytes;
+    for (int shift = 0; shift < 64; shift += 8) bytes.push_back((char)(value >> shift));
+    return bytes;
+}
+
+// Expand и None дают одно и то же множество; при гомоморфизме симметрия не снимается
+inline string QueryCache::modeKey(const SearchOptions& options) {
+    string mode(1, (char)options.semantics);
+    mode.push_back(options.symmetry == SymmetryMode::Break && breaksSymmetry(options) ? 'b' : 'a');
+    return mode;
+}
+
+inline shared_ptr<const QueryCache::Mappings> QueryCache::recall(const string& key) {
+    auto it = index.find(key);
+    if (it == index.end()) return nullptr;
+    recent.splice(recent.begin(), recent, it->second);
+    return it->second->mappings;
+}
+
+inline void QueryCache::remember(const string& key, shared_ptr<const Mappings> mappings) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+        recent.erase(it->second);
+        index.erase(it);
+    }
+    recent.push_front({key, move(mappings)});
+    index[key] = recent.begin();
+    while (recent.size() > capacity) {
+        index.erase(recent.back().key);
+        recent.pop_back();
+    }
+}
+
+inline uint64_t QueryCache::targetFingerprint(const Graph& target) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (fingerprintVersion == target.getVersion()) return fingerprint;
+    }
+    uint64_t value = graphFingerprint(target);
+    lock_guard<mutex> guard(lock);
+    fingerprintVersion = target.getVersion();
+    fingerprint = value;
+    return value;
+}
+
+inline string QueryCache::diskPath(const string& diskKey) const {
+    char name[24];
+    snprintf(name, sizeof(name), "%016llx.qc", (unsigned long long)certificateHash(diskKey));
+    return directory + "/" + name;
+}
+
+// Файл: "QCACHE1\n", длина ключа, ключ, число сопоставлений, размер паттерна,
+// затем номера (int32). Ключ сверяется при чтении — совпадение хэшей имён не страшно
+inline shared_ptr<const QueryCache::Mappings> QueryCache::loadDisk(const string& diskKey, size_t patternSize) const {
+    ifstream in(diskPath(diskKey), ios::binary);
+    if (!in) return nullptr;
+    char magic[8];
+    uint64_t keyBytes = 0, count = 0, k = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&keyBytes), sizeof(keyBytes));
+    if (!in || string(magic, sizeof(magic)) != string("QCACHE1\n", 8) || keyBytes != diskKey.size()) return nullptr;
+    string key(keyBytes, '\0');
+    in.read(&key[0], keyBytes);
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    in.read(reinterpret_cast<char*>(&k), sizeof(k));
+    if (!in || key != diskKey || (count > 0 && k != patternSize)) return nullptr;
+    auto mappings = make_shared<Mappings>();
+    vector<int> mapping(k);
+    for (uint64_t i = 0; i < count; ++i) {
+        in.read(reinterpret_cast<char*>(mapping.data()), k * sizeof(int));
+        if (!in) return nullptr;
+        mappings->push_back(mapping);
+    }
+    return mappings;
+}
+
+// Через временный файл: параллельный читатель не увидит запись наполовину
+inline void QueryCache::saveDisk(const string& diskKey, const Mappings& mappings) const {
+    string path = diskPath(diskKey);
+    string partial = path + ".tmp" + to_string(hash<thread::id>()(this_thread::get_id()));
+    {
+        ofstream out(partial, ios::binary | ios::trunc);
+        if (!out) return;
+        uint64_t keyBytes = diskKey.size(), count = mappings.size();
+        uint64_t k = mappings.empty() ? 0 : mappings[0].size();
+        out.write("QCACHE1\n", 8);
+        out.write(reinterpret_cast<const char*>(&keyBytes), sizeof(keyBytes));
+        out.write(diskKey.data(), keyBytes);
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(&k), sizeof(k));
+        for (const vector<int>& mapping : mappings) {
+            out.write(reinterpret_cast<const char*>(mapping.data()), k * sizeof(int));
+        }
+        if (!out) {
+            out.close();
+            remove(partial.c_str());
+            return;
+        }
+    }
+    if (rename(partial.c_str(), path.c_str()) != 0) remove(partial.c_str());
+}
+
+inline vector<vector<int>> QueryCache::findIsomorphicSubgraph(const Graph& target, const Graph& pattern,
+                                                              const SearchOptions& options) {
+    CanonicalForm form = pattern.canonicalForm();
+    string query = modeKey(options) + form.certificate;
+    string key = bytesOf(target.getVersion()) + query;
+    string diskKey;
+
+    shared_ptr<const Mappings> canonical;
+    {
+        lock_guard<mutex> guard(lock);
+        canonical = recall(key);
+        if (canonical) stats.hits++;
+    }
+    if (!canonical && !directory.empty()) {
+        diskKey = bytesOf(targetFingerprint(target)) + query;
+        canonical = loadDisk(diskKey, form.order.size());
+        if (canonical) {
+            lock_guard<mutex> guard(lock);
+            stats.diskHits++;
+            remember(key, canonical);
+        }
+    }
+
+    if (!canonical) {
+        Mappings mappings = target.findIsomorphicSubgraph(pattern, options);
+        sort(mappings.begin(), mappings.end());
+        bool complete = options.control == nullptr || options.control->getStatus() == SearchStatus::Completed;
+        auto translated = make_shared<Mappings>(complete ? mappings.size() : 0, vector<int>(form.order.size()));
+        for (size_t m = 0; m < translated->size(); ++m) {
+            for (size_t i = 0; i < form.order.size(); ++i) (*translated)[m][i] = mappings[m][form.order[i]];
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            stats.misses++;
+            if (complete) remember(key, translated);
+        }
+        if (complete && !directory.empty()) saveDisk(diskKey, *translated);
+        return mappings;
+    }
+
+    Mappings mappings(canonical->size(), vector<int>(form.order.size()));
+    for (size_t m = 0; m < mappings.size(); ++m) {
+        for (size_t i = 0; i < form.order.size(); ++i) mappings[m][form.order[i]] = (*canonical)[m][i];
+    }
+    sort(mappings.begin(), mappings.end());
+    return mappings;
+}
+
+inline size_t QueryCache::size() const {
+    lock_guard<mutex> guard(lock);
+    return recent.size();
+}
+
+inline void QueryCache::clear() {
+    lock_guard<mutex> guard(lock);
+    recent.clear();
+    index.clear();
+}
+
+inline QueryCacheStats QueryCache::getStats() const {
+    lock_guard<mutex> guard(lock);
+    return stats;
+}
+
+#endif
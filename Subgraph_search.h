@@ -0,0 +1,1909 @@
+#ifndef SUBGRAPH_SEARCH_H
+#define SUBGRAPH_SEARCH_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Bitset.h"
+#include "Pattern_families.h"
+#include "Thread_pool.h"
+
+using namespace std;
+
+// Алгоритм поиска изоморфного подграфа
+enum class MatchEngine {
+    Backtracking,   // перебор всех вершин графа на каждом уровне
+    VF2pp           // VF2++: кандидаты из окрестности, отсечение по терминальным множествам
+};
+
+// Что считается вхождением паттерна. Метки вершин и рёбер должны совпадать при любом режиме
+enum class MatchSemantics {
+    Induced,        // рёбра и не-рёбра паттерна сохраняются (индуцированный подграф)
+    Monomorphism,   // рёбра паттерна переходят в рёбра, лишние рёбра графа допустимы
+    Homomorphism    // как Monomorphism, но разные вершины паттерна могут перейти в одну
+};
+
+// Обработчик найденного сопоставления (паттерн -> граф); false — остановить поиск
+using MatchVisitor = function<bool(const vector<int>&)>;
+
+struct MatchCount {
+    uint64_t mappings = 0;      // число сопоставлений
+    uint64_t vertexSets = 0;    // число различных множеств вершин (если запрошено)
+};
+
+// План запроса: порядок сопоставления вершин паттерна. Строится один раз
+// и может использоваться повторно для того же паттерна
+struct MatchPlan {
+    vector<int> order;                  // order[depth] — вершина паттерна
+    vector<int> position;               // позиция вершины паттерна в order
+    vector<vector<int>> backNeighbors;  // соседи order[depth], стоящие раньше в порядке
+};
+
+// Учёт автоморфизмов паттерна
+enum class SymmetryMode {
+    None,       // все сопоставления, каждое ищется отдельно
+    Break,      // по одному сопоставлению на класс, эквивалентный по Aut(P)
+    Expand      // поиск как в Break, затем каждый найденный раскрывается до всего класса
+};
+
+struct PatternSymmetry;
+struct TargetIndex;
+
+enum class SearchStatus {
+    Running,
+    Completed,          // дерево пройдено или обработчик сам остановил поиск
+    TimedOut,
+    BudgetExhausted,    // исчерпан лимит узлов
+    Cancelled
+};
+
+// Управление долгим поиском: срок, лимит узлов, отмена из другого потока и
+// отчёт о ходе работы. Передаётся через SearchOptions::control; найденное до
+// остановки остаётся в результате поиска, причина остановки — в getStatus()
+class SearchControl {
+public:
+    using ProgressCallback = function<void(double)>;   // доля пройденных ветвей верхнего уровня
+
+    SearchControl() : cancelled(false), status(SearchStatus::Completed), nodes(0),
+                      nodeBudget(0), hasDeadline(false), hasTimeLimit(false), progress(0) {}
+
+    SearchControl(const SearchControl&) = delete;
+    SearchControl& operator=(const SearchControl&) = delete;
+
+    void setTimeLimit(chrono::steady_clock::duration limit);       // отсчёт от начала поиска
+    void setDeadline(chrono::steady_clock::time_point deadline);
+    void setNodeBudget(uint64_t budget) { nodeBudget = budget; }    // 0 — без ограничения
+    // Вызывается из потоков поиска не чаще раза в interval и один раз в конце
+    void setProgressCallback(ProgressCallback callback,
+                             chrono::steady_clock::duration interval = chrono::milliseconds(100));
+    // Потокобезопасно; отмена действует до reset()
+    void cancel() { cancelled = true; }
+    void reset() { cancelled = false; }
+
+    SearchStatus getStatus() const { return status; }
+    uint64_t getNodes() const { return nodes; }
+    double getProgress() const;
+    bool hasProgressCallback() const { return (bool)onProgress; }
+
+    // Вызывается поиском
+    void begin();
+    bool addNodes(uint64_t count);      // false — поиск пора останавливать
+    void addProgress(double fraction);
+    void finish();
+
+private:
+    atomic<bool> cancelled;
+    atomic<SearchStatus> status;
+    atomic<uint64_t> nodes;
+    uint64_t nodeBudget;
+    bool hasDeadline;
+    bool hasTimeLimit;
+    chrono::steady_clock::time_point deadline;
+    chrono::steady_clock::time_point activeDeadline;
+    chrono::steady_clock::duration timeLimit;
+
+    mutable mutex progressLock;
+    ProgressCallback onProgress;
+    chrono::steady_clock::duration progressInterval;
+    chrono::steady_clock::time_point lastReport;
+    double progress;
+
+    void stop(SearchStatus reason) {
+        SearchStatus running = SearchStatus::Running;
+        status.compare_exchange_strong(running, reason);
+    }
+};
+
+inline void SearchControl::setTimeLimit(chrono::steady_clock::duration limit) {
+    hasTimeLimit = true;
+    timeLimit = limit;
+}
+
+inline void SearchControl::setDeadline(chrono::steady_clock::time_point point) {
+    hasDeadline = true;
+    deadline = point;
+}
+
+inline void SearchControl::setProgressCallback(ProgressCallback callback,
+                                               chrono::steady_clock::duration interval) {
+    onProgress = move(callback);
+    progressInterval = interval;
+}
+
+inline double SearchControl::getProgress() const {
+    lock_guard<mutex> guard(progressLock);
+    return progress;
+}
+
+inline void SearchControl::begin() {
+    auto now = chrono::steady_clock::now();
+    nodes = 0;
+    progress = 0;
+    lastReport = now;
+    activeDeadline = chrono::steady_clock::time_point::max();
+    if (hasDeadline) activeDeadline = deadline;
+    if (hasTimeLimit) activeDeadline = min(activeDeadline, now + timeLimit);
+    status = SearchStatus::Running;
+    if (cancelled) stop(SearchStatus::Cancelled);
+}
+
+inline bool SearchControl::addNodes(uint64_t count) {
+    uint64_t total = nodes += count;
+    if (status != SearchStatus::Running) return false;
+    if (cancelled) {
+        stop(SearchStatus::Cancelled);
+    } else if (nodeBudget != 0 && total >= nodeBudget) {
+        stop(SearchStatus::BudgetExhausted);
+    } else if (activeDeadline != chrono::steady_clock::time_point::max() &&
+               chrono::steady_clock::now() >= activeDeadline) {
+        stop(SearchStatus::TimedOut);
+    }
+    return status == SearchStatus::Running;
+}
+
+inline void SearchControl::addProgress(double fraction) {
+    lock_guard<mutex> guard(progressLock);
+    progress = min(1.0, progress + fraction);
+    if (!onProgress) return;
+    auto now = chrono::steady_clock::now();
+    if (now - lastReport >= progressInterval) {
+        lastReport = now;
+        onProgress(progress);
+    }
+}
+
+inline void SearchControl::finish() {
+    stop(SearchStatus::Completed);
+    lock_guard<mutex> guard(progressLock);
+    if (status == SearchStatus::Completed) progress = 1.0;
+    if (onProgress) onProgress(progress);
+}
+
+// Счётчик узлов одного потока: в SearchControl узлы сбрасываются пачками, там же
+// проверяются срок и отмена. Лимит узлов соблюдается с точностью до
+// CONTROL_CHECK_INTERVAL узлов на поток. Ветви уровня startDepth, пройденные
+// до конца, дают по weight / branches к доле пройденного
+const int CONTROL_CHECK_INTERVAL = 256;
+
+struct ControlProbe {
+    SearchControl* control = nullptr;
+    int pending = 0;
+    int startDepth = 0;
+    double weight = 1.0;
+    size_t branches = 0;        // 0 — ход работы не отслеживается
+
+    bool tick() {
+        if (control == nullptr || ++pending < CONTROL_CHECK_INTERVAL) return true;
+        return flush();
+    }
+
+    bool flush() {
+        if (control == nullptr) return true;
+        bool proceed = control->addNodes(pending);
+        pending = 0;
+        return proceed;
+    }
+
+    void branchDone(int depth) {
+        if (branches != 0 && depth == startDepth) control->addProgress(weight / branches);
+    }
+};
+
+// Статистика поиска собирается, только если при сборке определён
+// SUBGRAPH_SEARCH_STATS; без него счётчики и замеры времени не компилируются
+#ifdef SUBGRAPH_SEARCH_STATS
+#define SEARCH_STAT(...) __VA_ARGS__
+#else
+#define SEARCH_STAT(...)
+#endif
+
+#ifdef SUBGRAPH_SEARCH_STATS
+struct SearchStats {
+    vector<uint64_t> nodesPerDepth;     // вызовы обхода на каждом уровне
+    uint64_t candidatesTried = 0;       // кандидатов, дошедших до assign
+    uint64_t matches = 0;               // полных сопоставлений до раскрытия симметрии
+    int maxDepth = 0;                   // наибольшая достигнутая глубина
+
+    // Отсев при построении доменов, в парах (вершина паттерна, вершина графа)
+    uint64_t domainLabel = 0;
+    uint64_t domainDegree = 0;
+    uint64_t domainNeighborDegrees = 0;
+    uint64_t domainTriangles = 0;
+    uint64_t domainArcConsistency = 0;
+
+    // Отсев при переборе, в кандидатах
+    uint64_t prunedDomain = 0;          // не входит в домен (VF2++)
+    uint64_t prunedInjectivity = 0;     // вершина графа уже занята (VF2++)
+    uint64_t prunedSymmetry = 0;        // нарушено ограничение снятия симметрии
+    uint64_t prunedDegree = 0;          // степень меньше, чем у вершины паттерна (VF2++)
+    uint64_t prunedAdjacency = 0;       // нет ребра к образу сопоставленного соседа (VF2++)
+    uint64_t prunedEdgeLabel = 0;       // не совпала метка ребра
+    uint64_t prunedLookahead = 0;       // не хватает соседей в терминальных множествах (VF2++)
+    uint64_t prunedForwardCheck = 0;    // опустел домен одной из следующих вершин (перебор с возвратом)
+
+    // Время по фазам, с: подготовка (план, домены, автоморфизмы), обход
+    // (включая обработчики) и выдача (обработчики, слияние и сортировка результатов;
+    // при нескольких потоках время обработчиков суммируется по потокам)
+    double preprocessSeconds = 0;
+    double searchSeconds = 0;
+    double outputSeconds = 0;
+
+    void enter(int depth) {
+        if ((int)nodesPerDepth.size() <= depth) nodesPerDepth.resize(depth + 1, 0);
+        nodesPerDepth[depth]++;
+        maxDepth = max(maxDepth, depth);
+    }
+
+    void merge(const SearchStats& other) {
+        if (nodesPerDepth.size() < other.nodesPerDepth.size()) {
+            nodesPerDepth.resize(other.nodesPerDepth.size(), 0);
+        }
+        for (size_t i = 0; i < other.nodesPerDepth.size(); ++i) {
+            nodesPerDepth[i] += other.nodesPerDepth[i];
+        }
+        candidatesTried += other.candidatesTried;
+        matches += other.matches;
+        maxDepth = max(maxDepth, other.maxDepth);
+        domainLabel += other.domainLabel;
+        domainDegree += other.domainDegree;
+        domainNeighborDegrees += other.domainNeighborDegrees;
+        domainTriangles += other.domainTriangles;
+        domainArcConsistency += other.domainArcConsistency;
+        prunedDomain += other.prunedDomain;
+        prunedInjectivity += other.prunedInjectivity;
+        prunedSymmetry += other.prunedSymmetry;
+        prunedDegree += other.prunedDegree;
+        prunedAdjacency += other.prunedAdjacency;
+        prunedEdgeLabel += other.prunedEdgeLabel;
+        prunedLookahead += other.prunedLookahead;
+        prunedForwardCheck += other.prunedForwardCheck;
+        preprocessSeconds += other.preprocessSeconds;
+        searchSeconds += other.searchSeconds;
+        outputSeconds += other.outputSeconds;
+    }
+};
+
+inline double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+#endif
+
+struct SearchOptions {
+    MatchEngine engine = MatchEngine::Backtracking;
+    MatchSemantics semantics = MatchSemantics::Induced;
+    int threads = 1;        // 0 — по числу ядер
+    int splitDepth = 2;     // до какой глубины дерево поиска режется на задачи
+    const MatchPlan* plan = nullptr;    // nullptr — план строится при каждом поиске
+    SymmetryMode symmetry = SymmetryMode::None;
+    const PatternSymmetry* automorphisms = nullptr;    // nullptr — группа строится при каждом поиске
+    const TargetIndex* targetIndex = nullptr;   // nullptr — характеристики графа считаются при каждом поиске
+    SearchControl* control = nullptr;   // срок, лимит узлов, отмена, ход работы
+    PatternFamily family = PatternFamily::Auto;     // ядро для клик, путей, циклов и звёзд; General — общий движок
+#ifdef SUBGRAPH_SEARCH_STATS
+    SearchStats* stats = nullptr;       // дописывается к уже накопленной статистике
+#endif
+};
+
+// Снятие симметрии корректно только для инъективных сопоставлений: при гомоморфизме
+// класс f∘Aut(P) может содержать меньше |Aut(P)| различных сопоставлений
+inline bool breaksSymmetry(const SearchOptions& options) {
+    return options.symmetry != SymmetryMode::None && options.semantics != MatchSemantics::Homomorphism;
+}
+
+// Число треугольников через каждую вершину (needed[v] == false — не считается)
+template <typename G>
+vector<int> countTriangles(const G& graph, const vector<char>& needed) {
+    int n = graph.getVertexCount();
+    vector<int> triangles(n, 0);
+    vector<int> mark(n, -1);
+    for (int v = 0; v < n; ++v) {
+        if (!needed[v]) continue;
+        for (int x : graph.getNeighbors(v)) mark[x] = v;
+        int twice = 0;
+        for (int x : graph.getNeighbors(v)) {
+            for (int y : graph.getNeighbors(x)) {
+                if (mark[y] == v) twice++;
+            }
+        }
+        triangles[v] = twice / 2;
+    }
+    return triangles;
+}
+
+// Степени соседей каждой вершины по убыванию, подряд в одном массиве
+template <typename G>
+void neighborDegrees(const G& graph, const vector<char>& needed,
+                     vector<int64_t>& offsets, vector<int>& degrees) {
+    int n = graph.getVertexCount();
+    offsets.assign(n + 1, 0);
+    for (int v = 0; v < n; ++v) {
+        offsets[v + 1] = offsets[v] + (needed[v] ? graph.getDegree(v) : 0);
+    }
+    degrees.resize(offsets[n]);
+    for (int v = 0; v < n; ++v) {
+        if (!needed[v]) continue;
+        int* out = degrees.data() + offsets[v];
+        for (int x : graph.getNeighbors(v)) *out++ = graph.getDegree(x);
+        sort(degrees.data() + offsets[v], out, greater<int>());
+    }
+}
+
+// Версия содержимого графа для проверки готовых характеристик: у Graph — getVersion(),
+// у неизменяемых графов (CsrGraph) её нет
+template <typename G>
+auto contentVersion(const G& graph, int) -> decltype(graph.getVersion()) { return graph.getVersion(); }
+
+template <typename G>
+uint64_t contentVersion(const G&, long) { return 0; }
+
+// Характеристики графа, не зависящие от паттерна: планировщик и отбор кандидатов
+// считают их при каждом поиске, а для серии запросов к одному графу их можно
+// посчитать один раз и передать через SearchOptions::targetIndex. После изменения
+// графа индекс не подходит (matches) и поиск считает характеристики заново
+struct TargetIndex {
+    int vertices = 0;
+    uint64_t version = 0;               // версия содержимого графа, см. contentVersion
+    vector<int> degreeAtLeast;          // degreeAtLeast[d] — число вершин степени не меньше d
+    vector<int> triangles;              // треугольники через каждую вершину
+    vector<int64_t> neighborOffsets;    // степени соседей по убыванию, см. neighborDegrees
+    vector<int> neighborDegreeList;
+    unordered_map<int, vector<int>> byLabel;   // вершины по меткам; пусто, если меток нет
+
+    template <typename Target>
+    bool matches(const Target& target) const {
+        return vertices == target.getVertexCount() && version == contentVersion(target, 0);
+    }
+};
+
+template <typename Target>
+TargetIndex buildTargetIndex(const Target& target) {
+    TargetIndex index;
+    int V = target.getVertexCount();
+    index.vertices = V;
+    index.version = contentVersion(target, 0);
+    index.degreeAtLeast.assign(V + 2, 0);
+    for (int v = 0; v < V; ++v) {
+        index.degreeAtLeast[target.getDegree(v)]++;
+    }
+    for (int d = V - 1; d >= 0; --d) {
+        index.degreeAtLeast[d] += index.degreeAtLeast[d + 1];
+    }
+    vector<char> all(V, 1);
+    index.triangles = countTriangles(target, all);
+    neighborDegrees(target, all, index.neighborOffsets, index.neighborDegreeList);
+    if (target.hasVertexLabels()) {
+        for (int v = 0; v < V; ++v) {
+            index.byLabel[target.getVertexLabel(v)].push_back(v);
+        }
+    }
+    return index;
+}
+
+// Жадный порядок (как в RI, GraphQL, VF2++): следующей берётся вершина с наибольшим
+// числом уже упорядоченных соседей, затем — с наибольшим числом соседей на границе
+// упорядоченного множества, затем — с самой редкой в графе степенью, затем — с наибольшей степенью
+template <typename Target, typename Pattern>
+MatchPlan buildMatchPlan(const Target& target, const Pattern& pattern, const TargetIndex* index = nullptr) {
+    int V = target.getVertexCount();
+    int patternV = pattern.getVertexCount();
+
+    // Редкость вершины паттерна: сколько вершин графа могут её принять по степени
+    vector<int> ownDegreeCount;
+    if (index == nullptr || !index->matches(target)) {
+        ownDegreeCount.assign(V + 2, 0);
+        for (int v = 0; v < V; ++v) {
+            ownDegreeCount[target.getDegree(v)]++;
+        }
+        for (int d = V - 1; d >= 0; --d) {
+            ownDegreeCount[d] += ownDegreeCount[d + 1];
+        }
+    }
+    const vector<int>& degreeCount = ownDegreeCount.empty() ? index->degreeAtLeast : ownDegreeCount;
+    auto rarity = [&](int u) {
+        int d = pattern.getDegree(u);
+        return d > V ? 0 : degreeCount[d];
+    };
+
+    MatchPlan plan;
+    plan.position.assign(patternV, -1);
+    vector<int> conn(patternV, 0);      // число упорядоченных соседей
+    vector<int> frontier(patternV, 0);  // число соседей, смежных упорядоченному множеству
+
+    auto better = [&](int a, int b) {
+        if (conn[a] != conn[b]) return conn[a] > conn[b];
+        if (frontier[a] != frontier[b]) return frontier[a] > frontier[b];
+        if (rarity(a) != rarity(b)) return rarity(a) < rarity(b);
+        return pattern.getDegree(a) > pattern.getDegree(b);
+    };
+
+    for (int depth = 0; depth < patternV; ++depth) {
+        int best = -1;
+        for (int u = 0; u < patternV; ++u) {
+            if (plan.position[u] == -1 && (best == -1 || better(u, best))) {
+                best = u;
+            }
+        }
+
+        plan.position[best] = depth;
+        plan.order.push_back(best);
+
+        vector<int> back;
+        for (int w : pattern.getNeighbors(best)) {
+            if (plan.position[w] != -1 && w != best) {
+                back.push_back(w);
+            }
+            if (conn[w]++ == 0) {
+                // w впервые оказался на границе — его соседям это засчитывается
+                for (int x : pattern.getNeighbors(w)) {
+                    frontier[x]++;
+                }
+            }
+        }
+        plan.backNeighbors.push_back(back);
+    }
+
+    return plan;
+}
+
+// Домены кандидатов: для каждой вершины паттерна — битовое множество вершин графа,
+// которые могут быть её образом
+struct CandidateDomains {
+    int rowWords = 0;
+    BitVector bits;
+    SEARCH_STAT(SearchStats stats;)
+
+    uint64_t* row(int u) { return bits.data() + (size_t)u * rowWords; }
+    const uint64_t* row(int u) const { return bits.data() + (size_t)u * rowWords; }
+};
+
+// Отбор кандидатов по меткам, степени, степеням соседей и треугольникам, затем
+// уточнение до согласованности по дугам (как в алгоритме Ульмана): v остаётся
+// в домене u, только если у каждого соседа u есть кандидат среди соседей v.
+// Счётные фильтры верны только для инъективных сопоставлений; при гомоморфизме
+// остаются метки, наличие соседей и согласованность по дугам.
+// index — готовые характеристики того же графа (nullptr — считаются здесь).
+// Возвращает false, если какой-то домен опустел
+template <typename Target, typename Pattern>
+bool buildCandidateDomains(const Target& target, const Pattern& pattern, MatchSemantics semantics,
+                           CandidateDomains& domains, const TargetIndex* index = nullptr) {
+    int V = target.getVertexCount();
+    int patternV = pattern.getVertexCount();
+    domains.rowWords = bitRowWords(V);
+    domains.bits.assign((size_t)patternV * domains.rowWords, 0);
+    if (patternV == 0) return true;
+
+    bool injective = semantics != MatchSemantics::Homomorphism;
+    bool edgeLabelled = pattern.hasEdgeLabels() || target.hasEdgeLabels();
+
+    if (index != nullptr && !index->matches(target)) index = nullptr;
+
+    // Счётные характеристики нужны только при инъективном сопоставлении; в готовом
+    // индексе они посчитаны для всех вершин
+    vector<char> targetNeeded(V, index != nullptr), patternNeeded(patternV, injective);
+    if (injective && index == nullptr) {
+        int minDegree = V;
+        for (int u = 0; u < patternV; ++u) {
+            minDegree = min(minDegree, pattern.getDegree(u));
+        }
+        for (int v = 0; v < V; ++v) {
+            targetNeeded[v] = target.getDegree(v) >= minDegree;
+        }
+    }
+
+    vector<int> patternTriangles = countTriangles(pattern, patternNeeded);
+    bool anyTriangles = any_of(patternTriangles.begin(), patternTriangles.end(),
+                               [](int t) { return t > 0; });
+    vector<int> ownTriangles;
+    if (anyTriangles && index == nullptr) ownTriangles = countTriangles(target, targetNeeded);
+    const vector<int>& targetTriangles = index != nullptr ? index->triangles : ownTriangles;
+
+    vector<int64_t> patternOffsets, ownOffsets;
+    vector<int> patternNeighborDegrees, ownNeighborDegrees;
+    neighborDegrees(pattern, patternNeeded, patternOffsets, patternNeighborDegrees);
+    if (index == nullptr) neighborDegrees(target, targetNeeded, ownOffsets, ownNeighborDegrees);
+    const vector<int64_t>& targetOffsets = index != nullptr ? index->neighborOffsets : ownOffsets;
+    const vector<int>& targetNeighborDegrees = index != nullptr ? index->neighborDegreeList : ownNeighborDegrees;
+
+    auto accepts = [&](int u, int v) {
+        int degree = pattern.getDegree(u);
+        if (!injective) {
+            if (degree == 0 || target.getDegree(v) > 0) return true;
+            SEARCH_STAT(domains.stats.domainDegree++);
+            return false;
+        }
+        if (!targetNeeded[v] || target.getDegree(v) < degree) {
+            SEARCH_STAT(domains.stats.domainDegree++);
+            return false;
+        }
+        if (anyTriangles && targetTriangles[v] < patternTriangles[u]) {
+            SEARCH_STAT(domains.stats.domainTriangles++);
+            return false;
+        }
+        // Соседи u вкладываются в соседей v, значит k-я по величине степень
+        // соседа v не меньше k-й степени соседа u
+        const int* pd = patternNeighborDegrees.data() + patternOffsets[u];
+        const int* td = targetNeighborDegrees.data() + targetOffsets[v];
+        for (int k = 0; k < degree; ++k) {
+            if (td[k] < pd[k]) {
+                SEARCH_STAT(domains.stats.domainNeighborDegrees++);
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Индекс вершин графа по меткам: кандидаты перебираются только среди вершин с той же меткой
+    bool vertexLabelled = pattern.hasVertexLabels() || target.hasVertexLabels();
+    unordered_map<int, vector<int>> ownByLabel;
+    if (vertexLabelled && (index == nullptr || !target.hasVertexLabels())) {
+        for (int v = 0; v < V; ++v) {
+            ownByLabel[target.getVertexLabel(v)].push_back(v);
+        }
+    }
+    const unordered_map<int, vector<int>>& byLabel =
+        index != nullptr && target.hasVertexLabels() ? index->byLabel : ownByLabel;
+
+    for (int u = 0; u < patternV; ++u) {
+        uint64_t* dom = domains.row(u);
+        if (vertexLabelled) {
+            auto it = byLabel.find(pattern.getVertexLabel(u));
+            if (it == byLabel.end()) {
+                SEARCH_STAT(domains.stats.domainLabel += V);
+                return false;
+            }
+            SEARCH_STAT(domains.stats.domainLabel += V - it->second.size());
+            for (int v : it->second) {
+                if (accepts(u, v)) bitSet(dom, v);
+            }
+        } else {
+            for (int v = 0; v < V; ++v) {
+                if (accepts(u, v)) bitSet(dom, v);
+            }
+        }
+        if (!bitsAny(dom, domains.rowWords)) return false;
+    }
+
+    // AC-3 по рёбрам паттерна
+    vector<int> queue;
+    vector<char> queued(patternV, 1);
+    for (int u = patternV - 1; u >= 0; --u) queue.push_back(u);
+
+    while (!queue.empty()) {
+        int u = queue.back();
+        queue.pop_back();
+        queued[u] = 0;
+
+        uint64_t* dom = domains.row(u);
+        bool changed = false;
+        for (int w = 0; w < domains.rowWords; ++w) {
+            uint64_t bits = dom[w];
+            while (bits) {
+                int v = w * BIT_WORD_BITS + bitLowestWord(bits);
+                bits &= bits - 1;
+                for (int pu : pattern.getNeighbors(u)) {
+                    const uint64_t* neighborDom = domains.row(pu);
+                    bool supported = false;
+                    for (int x : target.getNeighbors(v)) {
+                        if (bitTest(neighborDom, x) &&
+                            (!edgeLabelled || target.getEdgeLabel(v, x) == pattern.getEdgeLabel(u, pu))) {
+                            supported = true;
+                            break;
+                        }
+                    }
+                    if (!supported) {
+                        bitClear(dom, v);
+                        SEARCH_STAT(domains.stats.domainArcConsistency++);
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (changed) {
+            if (!bitsAny(dom, domains.rowWords)) return false;
+            for (int pu : pattern.getNeighbors(u)) {
+                if (!queued[pu]) {
+                    queued[pu] = 1;
+                    queue.push_back(pu);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Группа автоморфизмов паттерна в виде цепочки стабилизаторов: на уровне i
+// берётся стабилизатор вершин base[0..i-1], orbits[i] — орбита base[i] в нём
+// (orbits[i][0] == base[i]), transversal[i][j] — автоморфизм из того же
+// стабилизатора, переводящий base[i] в orbits[i][j]. Уровни с тривиальной
+// орбитой не хранятся
+struct PatternSymmetry {
+    vector<int> base;
+    vector<vector<int>> orbits;
+    vector<vector<vector<int>>> transversal;
+    uint64_t automorphisms = 1;     // |Aut(P)| — произведение размеров орбит
+};
+
+// Поиск автоморфизма, продолжающего частичную перестановку perm (-1 — свободно);
+// order — порядок вершин, заданные в perm вершины идут в нём первыми
+template <typename Pattern>
+bool extendAutomorphism(const Pattern& pattern, const vector<int>& order, int depth,
+                        vector<int>& perm, vector<char>& used, const vector<int>& forced) {
+    int n = (int)order.size();
+    if (depth == n) return true;
+
+    int u = order[depth];
+    int first = forced[u] == -1 ? 0 : forced[u];
+    int last = forced[u] == -1 ? n - 1 : forced[u];
+    for (int w = first; w <= last; ++w) {
+        if (used[w] || pattern.getDegree(w) != pattern.getDegree(u) ||
+            pattern.getVertexLabel(w) != pattern.getVertexLabel(u)) continue;
+        bool consistent = true;
+        for (int d = 0; d < depth; ++d) {
+            int x = order[d];
+            bool edge = pattern.hasEdge(u, x);
+            if (edge != pattern.hasEdge(w, perm[x]) ||
+                (edge && pattern.getEdgeLabel(u, x) != pattern.getEdgeLabel(w, perm[x]))) {
+                consistent = false;
+                break;
+            }
+        }
+        if (!consistent) continue;
+
+        perm[u] = w;
+        used[w] = 1;
+        if (extendAutomorphism(pattern, order, depth + 1, perm, used, forced)) return true;
+        used[w] = 0;
+        perm[u] = -1;
+    }
+    return false;
+}
+
+// Цепочка стабилизаторов по вершинам в порядке baseOrder (nullptr — 0..n-1);
+// автоморфизмы сохраняют метки вершин и рёбер.
+// Для каждой вершины орбита ищется прямой проверкой всех кандидатов той же
+// степени: паттерны малы, и каждая проверка обычно решается без возвратов
+template <typename Pattern>
+PatternSymmetry buildPatternSymmetry(const Pattern& pattern, const vector<int>* baseOrder = nullptr) {
+    int n = pattern.getVertexCount();
+    vector<int> bases(n);
+    for (int i = 0; i < n; ++i) {
+        bases[i] = baseOrder != nullptr && (int)baseOrder->size() == n ? (*baseOrder)[i] : i;
+    }
+
+    PatternSymmetry symmetry;
+    vector<int> forced(n, -1);
+    for (int i = 0; i < n; ++i) {
+        int b = bases[i];
+
+        // Порядок для поиска: зафиксированные вершины, затем жадно по связности
+        vector<int> order(bases.begin(), bases.begin() + i + 1);
+        vector<char> placed(n, 0);
+        vector<int> conn(n, 0);
+        for (int x : order) {
+            placed[x] = 1;
+            for (int w : pattern.getNeighbors(x)) conn[w]++;
+        }
+        while ((int)order.size() < n) {
+            int best = -1;
+            for (int w = 0; w < n; ++w) {
+                if (!placed[w] && (best == -1 || conn[w] > conn[best] ||
+                                   (conn[w] == conn[best] && pattern.getDegree(w) > pattern.getDegree(best)))) {
+                    best = w;
+                }
+            }
+            placed[best] = 1;
+            order.push_back(best);
+            for (int w : pattern.getNeighbors(best)) conn[w]++;
+        }
+
+        vector<int> orbit(1, b);
+        vector<vector<int>> reps(1, vector<int>(n));
+        for (int x = 0; x < n; ++x) reps[0][x] = x;
+
+        for (int c = 0; c < n; ++c) {
+            if (c == b || forced[c] != -1 || pattern.getDegree(c) != pattern.getDegree(b) ||
+                pattern.getVertexLabel(c) != pattern.getVertexLabel(b)) continue;
+            vector<int> perm(n, -1);
+            vector<char> used(n, 0);
+            forced[b] = c;
+            if (extendAutomorphism(pattern, order, 0, perm, used, forced)) {
+                orbit.push_back(c);
+                reps.push_back(perm);
+            }
+        }
+        forced[b] = b;
+
+        if (orbit.size() > 1) {
+            symmetry.base.push_back(b);
+            symmetry.orbits.push_back(orbit);
+            symmetry.transversal.push_back(reps);
+            symmetry.automorphisms *= orbit.size();
+        }
+    }
+    return symmetry;
+}
+
+// Ограничения, снимающие симметрию (как у Грохова–Келлиса): образ base[i] меньше
+// образов остальных вершин его орбиты. Тогда из каждого класса сопоставлений
+// f∘Aut(P) остаётся ровно одно. В терминах плана: образ вершины уровня depth
+// больше образов greater[depth] и меньше образов less[depth]
+struct SymmetryBounds {
+    vector<vector<int>> greater;
+    vector<vector<int>> less;
+
+    // Допустимый интервал (low, high) для образа вершины уровня depth
+    void range(int depth, const vector<int>& mapping, int& low, int& high) const {
+        if (greater.empty()) return;
+        for (int w : greater[depth]) low = max(low, mapping[w]);
+        for (int w : less[depth]) high = min(high, mapping[w]);
+    }
+};
+
+inline SymmetryBounds buildSymmetryBounds(const MatchPlan& plan, const PatternSymmetry& symmetry) {
+    SymmetryBounds bounds;
+    bounds.greater.resize(plan.order.size());
+    bounds.less.resize(plan.order.size());
+    for (size_t i = 0; i < symmetry.base.size(); ++i) {
+        int a = symmetry.base[i];
+        for (size_t j = 1; j < symmetry.orbits[i].size(); ++j) {
+            int b = symmetry.orbits[i][j];
+            // Проверка — на уровне той из двух вершин, что сопоставляется позже
+            if (plan.position[a] < plan.position[b]) {
+                bounds.greater[plan.position[b]].push_back(a);
+            } else {
+                bounds.less[plan.position[a]].push_back(b);
+            }
+        }
+    }
+    return bounds;
+}
+
+// Все сопоставления класса mapping∘Aut(P): произведения представителей
+// transversal[0]∘transversal[1]∘... перебирают группу ровно по разу
+template <typename Func>
+bool expandSymmetry(const PatternSymmetry& symmetry, size_t level, vector<vector<int>>& current, Func& func) {
+    if (level == symmetry.base.size()) {
+        return func(current[level]);
+    }
+    const vector<int>& prev = current[level];
+    vector<int>& next = current[level + 1];
+    for (const vector<int>& rep : symmetry.transversal[level]) {
+        next.resize(prev.size());
+        for (size_t u = 0; u < prev.size(); ++u) {
+            next[u] = prev[rep[u]];
+        }
+        if (!expandSymmetry(symmetry, level + 1, current, func)) return false;
+    }
+    return true;
+}
+
+// Движки поиска. Общий интерфейс состояния:
+//   size()                        — число вершин паттерна
+//   startCandidates(depth)        — начать перебор допустимых вершин графа для уровня depth
+//   nextCandidate(depth, v)       — следующая допустимая вершина; false, если их больше нет.
+//                                   Курсоры уровней хранятся в движке, память выделяется
+//                                   один раз при создании, а не на каждый узел
+//   assign / unassign             — сопоставление вершины уровня depth; assign
+//                                   возвращает false, если ветку можно отсечь сразу
+//   getMapping()                  — текущее сопоставление (паттерн -> граф)
+// Все условия проверяются по мере сопоставления, полное сопоставление отдельно не проверяется
+
+// Наибольший размер паттерна, для которого перебор с возвратом собирается с размером,
+// известным при компиляции
+const int MAX_FIXED_PATTERN = 16;
+
+// Перебор с возвратом: вершины паттерна берутся в порядке плана. Для каждой
+// ещё не сопоставленной вершины поддерживается её текущий домен; после каждого
+// сопоставления домены сужаются строкой образа (проверка вперёд), и ветка
+// отсекается, как только какой-то из них опустеет.
+// При P > 0 паттерн ровно из P вершин: состояние уровней лежит в массивах
+// фиксированной длины, и циклы по вершинам паттерна имеют постоянную границу
+template <typename Target, typename Pattern, int P = 0>
+class BacktrackEngine {
+private:
+    template <typename T>
+    using Slots = typename conditional<(P > 0), array<T, (P > 0 ? P : 1)>, vector<T>>::type;
+    template <typename T>
+    using Cells = typename conditional<(P > 0), array<T, (P > 0 ? P * P : 1)>, vector<T>>::type;
+
+    template <typename T>
+    static void resizeSlots(vector<T>& slots, size_t n) { slots.assign(n, T()); }
+    template <typename T, size_t N>
+    static void resizeSlots(array<T, N>& slots, size_t) { slots.fill(T()); }
+
+    const Target* target;
+    const Pattern* pattern;
+    MatchPlan plan;
+    SymmetryBounds bounds;
+    MatchSemantics semantics;
+    bool edgeLabelled;
+    int V;
+    int patternV;
+    int rowWords;
+    vector<int> mapping;
+    Slots<int> order;
+    Cells<char> adjacent;   // adjacent[i * patternV + j] — смежность order[i] и order[j]
+    BitVector levels;       // домены на каждом уровне: (patternV + 1) x patternV строк
+
+    // Курсор перебора кандидатов уровня: слово домена, ещё не выданные биты, допустимый интервал
+    Slots<int> cursorWord;
+    Slots<uint64_t> cursorBits;
+    Slots<int> cursorLow;
+    Slots<int> cursorHigh;
+
+    int count() const { return P > 0 ? P : patternV; }
+    uint64_t* domain(int level, int position) {
+        return levels.data() + ((size_t)level * count() + position) * rowWords;
+    }
+
+public:
+    SEARCH_STAT(SearchStats stats;)
+
+    BacktrackEngine(const Target& targetGraph, const Pattern& patternGraph, const MatchPlan& matchPlan,
+                    const CandidateDomains& domains, const SymmetryBounds& symmetryBounds,
+                    MatchSemantics matchSemantics)
+        : target(&targetGraph), pattern(&patternGraph), plan(matchPlan), bounds(symmetryBounds),
+          semantics(matchSemantics), edgeLabelled(patternGraph.hasEdgeLabels() || targetGraph.hasEdgeLabels()),
+          V(targetGraph.getVertexCount()), patternV(patternGraph.getVertexCount()),
+          rowWords(targetGraph.getRowWords()), mapping(patternV, -1),
+          levels((size_t)(patternV + 1) * patternV * rowWords) {
+        resizeSlots(order, patternV);
+        resizeSlots(adjacent, (size_t)patternV * patternV);
+        resizeSlots(cursorWord, patternV);
+        resizeSlots(cursorBits, patternV);
+        resizeSlots(cursorLow, patternV);
+        resizeSlots(cursorHigh, patternV);
+        for (int i = 0; i < patternV; ++i) {
+            order[i] = plan.order[i];
+            for (int j = 0; j < patternV; ++j) {
+                adjacent[i * patternV + j] = patternGraph.hasEdge(plan.order[i], plan.order[j]);
+            }
+            copy(domains.row(plan.order[i]), domains.row(plan.order[i]) + rowWords, domain(0, i));
+        }
+    }
+
+    int size() const { return count(); }
+    const vector<int>& getMapping() const { return mapping; }
+
+    void startCandidates(int depth) {
+        int low = -1, high = V;
+        bounds.range(depth, mapping, low, high);
+        int word = (low + 1) / BIT_WORD_BITS;
+        cursorLow[depth] = low;
+        cursorHigh[depth] = high;
+        cursorWord[depth] = word;
+        cursorBits[depth] = word < rowWords ? domain(depth, depth)[word] : 0;
+    }
+
+    bool nextCandidate(int depth, int& v) {
+        const uint64_t* cand = domain(depth, depth);
+        uint64_t bits = cursorBits[depth];
+        int word = cursorWord[depth];
+        while (true) {
+            while (bits == 0) {
+                if (++word >= rowWords) {
+                    cursorWord[depth] = word;
+                    cursorBits[depth] = 0;
+                    return false;
+                }
+                bits = cand[word];
+            }
+            v = word * BIT_WORD_BITS + bitLowestWord(bits);
+            bits &= bits - 1;
+            if (v <= cursorLow[depth]) {
+                SEARCH_STAT(stats.prunedSymmetry++);
+                continue;
+            }
+            if (v >= cursorHigh[depth]) {
+                SEARCH_STAT(stats.prunedSymmetry += 1 + bitCountWord(bits) +
+                                                    bitsCount(cand + word + 1, rowWords - word - 1));
+                cursorWord[depth] = rowWords;
+                cursorBits[depth] = 0;
+                return false;
+            }
+            cursorWord[depth] = word;
+            cursorBits[depth] = bits;
+            return true;
+        }
+    }
+
+    bool assign(int depth, int v) {
+        int u = order[depth];
+        mapping[u] = v;
+
+        if (edgeLabelled) {
+            for (int w : plan.backNeighbors[depth]) {
+                if (pattern->getEdgeLabel(u, w) != target->getEdgeLabel(v, mapping[w])) {
+                    SEARCH_STAT(stats.prunedEdgeLabel++);
+                    return false;
+                }
+            }
+        }
+
+        // Смежные с order[depth] вершины должны перейти в соседей v, несмежные —
+        // в несоседей (только для индуцированного подграфа); v занята, если
+        // сопоставление инъективно
+        const uint64_t* row = target->getAdjRow(v);
+        const int k = count();
+        for (int j = depth + 1; j < k; ++j) {
+            uint64_t* dst = domain(depth + 1, j);
+            bool nonEmpty = true;
+            if (adjacent[depth * k + j]) {
+                nonEmpty = bitsAnd(dst, domain(depth, j), row, rowWords);
+            } else if (semantics == MatchSemantics::Induced) {
+                nonEmpty = bitsAndNot(dst, domain(depth, j), row, rowWords);
+            } else {
+                copy(domain(depth, j), domain(depth, j) + rowWords, dst);
+            }
+            if (semantics != MatchSemantics::Homomorphism) {
+                bitClear(dst, v);
+                if (nonEmpty && dst[v / BIT_WORD_BITS] == 0) {
+                    nonEmpty = bitsAny(dst, rowWords);
+                }
+            }
+            if (!nonEmpty) {
+                SEARCH_STAT(stats.prunedForwardCheck++);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void unassign(int depth) {
+        mapping[order[depth]] = -1;
+    }
+};
+
+// VF2++: вершины паттерна берутся в порядке плана, кандидаты — из окрестности
+// образа того уже сопоставленного соседа, у которого она меньше
+template <typename Target, typename Pattern>
+class Vf2ppEngine {
+private:
+    const Target* target;
+    const Pattern* pattern;
+    MatchPlan plan;
+    const CandidateDomains* domains;
+    SymmetryBounds bounds;
+    MatchSemantics semantics;
+    bool injective;
+    bool edgeLabelled;
+    int V;
+    int patternV;
+    vector<int> core1;    // паттерн -> граф
+    vector<int> core2;    // граф -> паттерн
+    vector<int> term1;    // число сопоставленных соседей вершины паттерна
+    vector<int> term2;    // число сопоставленных соседей вершины графа
+
+    using NeighborIterator = decltype(declval<const Target&>().getNeighbors(0).begin());
+    struct Cursor {
+        bool fromNeighbors = false;
+        NeighborIterator next{}, end{};
+        int word = 0;
+        uint64_t bits = 0;
+        int low = -1, high = 0;
+    };
+    vector<Cursor> cursors;
+
+    bool feasible(int u, int v) const;
+
+public:
+    SEARCH_STAT(mutable SearchStats stats;)
+
+    Vf2ppEngine(const Target& targetGraph, const Pattern& patternGraph, const MatchPlan& matchPlan,
+                const CandidateDomains& candidateDomains, const SymmetryBounds& symmetryBounds,
+                MatchSemantics matchSemantics)
+        : target(&targetGraph), pattern(&patternGraph), plan(matchPlan), domains(&candidateDomains),
+          bounds(symmetryBounds), semantics(matchSemantics),
+          injective(matchSemantics != MatchSemantics::Homomorphism),
+          edgeLabelled(patternGraph.hasEdgeLabels() || targetGraph.hasEdgeLabels()),
+          V(targetGraph.getVertexCount()), patternV(patternGraph.getVertexCount()),
+          core1(patternV, -1), core2(V, -1), term1(patternV, 0), term2(V, 0), cursors(patternV) {}
+
+    int size() const { return patternV; }
+    const vector<int>& getMapping() const { return core1; }
+
+    // С сопоставленными соседями кандидаты — окрестность образа того из них, у которого
+    // она меньше; без них — домен по битам
+    void startCandidates(int depth) {
+        int u = plan.order[depth];
+        const vector<int>& back = plan.backNeighbors[depth];
+        int low = -1, high = V;
+        bounds.range(depth, core1, low, high);
+        Cursor& cursor = cursors[depth];
+        cursor.low = low;
+        cursor.high = high;
+        cursor.fromNeighbors = !back.empty();
+        if (cursor.fromNeighbors) {
+            // Образ u обязан быть соседом образов всех уже сопоставленных соседей
+            int anchor = core1[back[0]];
+            for (int w : back) {
+                if (target->getDegree(core1[w]) < target->getDegree(anchor)) {
+                    anchor = core1[w];
+                }
+            }
+            const auto& neighbors = target->getNeighbors(anchor);
+            cursor.next = neighbors.begin();
+            cursor.end = neighbors.end();
+        } else {
+            cursor.word = (low + 1) / BIT_WORD_BITS;
+            cursor.bits = cursor.word < domains->rowWords ? domains->row(u)[cursor.word] : 0;
+        }
+    }
+
+    bool nextCandidate(int depth, int& v) {
+        int u = plan.order[depth];
+        const uint64_t* dom = domains->row(u);
+        Cursor& cursor = cursors[depth];
+        if (cursor.fromNeighbors) {
+            while (cursor.next != cursor.end) {
+                v = *cursor.next;
+                ++cursor.next;
+                if (v <= cursor.low || v >= cursor.high) {
+                    SEARCH_STAT(stats.prunedSymmetry++);
+                    continue;
+                }
+                if (!bitTest(dom, v)) {
+                    SEARCH_STAT(stats.prunedDomain++);
+                    continue;
+                }
+                if (injective && core2[v] != -1) {
+                    SEARCH_STAT(stats.prunedInjectivity++);
+                    continue;
+                }
+                if (feasible(u, v)) return true;
+            }
+            return false;
+        }
+        while (true) {
+            while (cursor.bits == 0) {
+                if (++cursor.word >= domains->rowWords) return false;
+                cursor.bits = dom[cursor.word];
+            }
+            v = cursor.word * BIT_WORD_BITS + bitLowestWord(cursor.bits);
+            cursor.bits &= cursor.bits - 1;
+            if (v <= cursor.low) {
+                SEARCH_STAT(stats.prunedSymmetry++);
+                continue;
+            }
+            if (v >= cursor.high) {
+                SEARCH_STAT(stats.prunedSymmetry += 1 + bitCountWord(cursor.bits) +
+                                                    bitsCount(dom + cursor.word + 1, domains->rowWords - cursor.word - 1));
+                cursor.word = domains->rowWords;
+                cursor.bits = 0;
+                return false;
+            }
+            if (injective && core2[v] != -1) {
+                SEARCH_STAT(stats.prunedInjectivity++);
+                continue;
+            }
+            if (feasible(u, v)) return true;
+        }
+    }
+
+    // При гомоморфизме одна вершина графа может быть образом нескольких вершин,
+    // core2 и терминальные множества не ведутся
+    bool assign(int depth, int v) {
+        int u = plan.order[depth];
+        core1[u] = v;
+        if (!injective) return true;
+        core2[v] = u;
+        for (int w : pattern->getNeighbors(u)) term1[w]++;
+        for (int x : target->getNeighbors(v)) term2[x]++;
+        return true;
+    }
+
+    void unassign(int depth) {
+        int u = plan.order[depth];
+        int v = core1[u];
+        core1[u] = -1;
+        if (!injective) return;
+        for (int w : pattern->getNeighbors(u)) term1[w]--;
+        for (int x : target->getNeighbors(v)) term2[x]--;
+        core2[v] = -1;
+    }
+};
+
+template <typename Target, typename Pattern>
+bool Vf2ppEngine<Target, Pattern>::feasible(int u, int v) const {
+    if (injective && pattern->getDegree(u) > target->getDegree(v)) {
+        SEARCH_STAT(stats.prunedDegree++);
+        return false;
+    }
+
+    int matched1 = 0, terminal1 = 0, new1 = 0;
+    for (int w : pattern->getNeighbors(u)) {
+        if (core1[w] != -1) {
+            if (!target->hasEdge(v, core1[w])) {
+                SEARCH_STAT(stats.prunedAdjacency++);
+                return false;
+            }
+            if (edgeLabelled && pattern->getEdgeLabel(u, w) != target->getEdgeLabel(v, core1[w])) {
+                SEARCH_STAT(stats.prunedEdgeLabel++);
+                return false;
+            }
+            matched1++;
+        } else if (term1[w] > 0) {
+            terminal1++;
+        } else {
+            new1++;
+        }
+    }
+    if (!injective) {
+        return true;
+    }
+
+    int matched2 = 0, terminal2 = 0, new2 = 0;
+    for (int x : target->getNeighbors(v)) {
+        if (core2[x] != -1) {
+            matched2++;
+        } else if (term2[x] > 0) {
+            terminal2++;
+        } else {
+            new2++;
+        }
+    }
+
+    // Индуцированный подграф: лишних рёбер к сопоставленным вершинам быть не должно,
+    // а соседей из терминального множества и новых соседей у v должно хватить.
+    // При мономорфизме новый сосед u может перейти и в терминальную вершину,
+    // поэтому сравниваются только суммы
+    bool fits = semantics == MatchSemantics::Induced
+        ? matched1 == matched2 && terminal1 <= terminal2 && new1 <= new2
+        : terminal1 + new1 <= terminal2 + new2;
+    if (!fits) {
+        SEARCH_STAT(stats.prunedLookahead++);
+    }
+    return fits;
+}
+
+// Обход дерева поиска с уровня depth (уровни до него уже сопоставлены); visit
+// возвращает false для остановки, probe — по исчерпании срока, лимита узлов или
+// при отмене. Обход итеративный: стек — курсоры уровней внутри движка
+template <typename Engine, typename Visitor>
+bool searchFrom(Engine& engine, int depth, Visitor& visit, ControlProbe& probe) {
+    if (!probe.tick()) return false;
+    SEARCH_STAT(engine.stats.enter(depth));
+    const int size = engine.size();
+    if (depth == size) {
+        SEARCH_STAT(engine.stats.matches++);
+        return visit(engine.getMapping());
+    }
+
+    // При остановке снимаются все сопоставления выше начального уровня
+    const int base = depth;
+    auto unwind = [&](int from) {
+        for (int d = from; d >= base; --d) engine.unassign(d);
+        return false;
+    };
+    engine.startCandidates(depth);
+    while (true) {
+        int v;
+        if (!engine.nextCandidate(depth, v)) {
+            if (depth == base) return true;
+            --depth;
+            engine.unassign(depth);
+            probe.branchDone(depth);
+            continue;
+        }
+        SEARCH_STAT(engine.stats.candidatesTried++);
+        if (!engine.assign(depth, v)) {
+            engine.unassign(depth);
+            probe.branchDone(depth);
+            continue;
+        }
+        if (!probe.tick()) return unwind(depth);
+        SEARCH_STAT(engine.stats.enter(depth + 1));
+        if (depth + 1 == size) {
+            SEARCH_STAT(engine.stats.matches++);
+            if (!visit(engine.getMapping())) return unwind(depth);
+            engine.unassign(depth);
+            probe.branchDone(depth);
+            continue;
+        }
+        ++depth;
+        engine.startCandidates(depth);
+    }
+}
+
+// Число кандидатов уровня depth — знаменатель для доли пройденного
+template <typename Engine>
+size_t countBranches(Engine& engine, int depth) {
+    size_t branches = 0;
+    if (depth < engine.size()) {
+        int v;
+        engine.startCandidates(depth);
+        while (engine.nextCandidate(depth, v)) branches++;
+    }
+    return branches;
+}
+
+inline int resolveThreads(const SearchOptions& options) {
+    if (options.threads <= 0) {
+        return max(1u, thread::hardware_concurrency());
+    }
+    return options.threads;
+}
+
+// Параллельный поиск: верхние splitDepth уровней дерева режутся на задачи,
+// у каждого исполнителя свой экземпляр движка. visit(worker, mapping) вызывается
+// из разных потоков с разными worker; false останавливает весь поиск
+template <typename Engine, typename Visitor>
+bool parallelSearch(const Engine& prototype, const SearchOptions& options, Visitor& visit) {
+    int splitDepth = options.splitDepth;
+    WorkStealingPool pool(resolveThreads(options));
+    vector<Engine> engines(pool.size(), prototype);
+    atomic<bool> stopped(false);
+
+    // weight — доля всего дерева, приходящаяся на поддерево задачи
+    function<void(int, vector<int>, double)> expand = [&](int worker, vector<int> prefix, double weight) {
+        if (stopped) return;
+
+        Engine& engine = engines[worker];
+        int depth = (int)prefix.size();
+        for (int d = 0; d < depth; ++d) {
+            if (!engine.assign(d, prefix[d])) {
+                // Ветка отсекается проверкой вперёд
+                for (; d >= 0; --d) {
+                    engine.unassign(d);
+                }
+                return;
+            }
+        }
+
+        ControlProbe probe;
+        probe.control = options.control;
+        if (depth < splitDepth && depth < engine.size()) {
+            SEARCH_STAT(engine.stats.enter(depth));
+            vector<int> children;
+            int v;
+            engine.startCandidates(depth);
+            while (engine.nextCandidate(depth, v)) {
+                SEARCH_STAT(engine.stats.candidatesTried++);
+                children.push_back(v);
+            }
+            if (children.empty() && probe.control != nullptr) {
+                probe.control->addProgress(weight);
+            }
+            for (int v : children) {
+                vector<int> child = prefix;
+                child.push_back(v);
+                double childWeight = weight / children.size();
+                pool.submit([&expand, child, childWeight](int w) { expand(w, child, childWeight); });
+            }
+        } else {
+            auto workerVisit = [&](const vector<int>& mapping) {
+                if (stopped || !visit(worker, mapping)) {
+                    stopped = true;
+                    return false;
+                }
+                return true;
+            };
+            if (probe.control != nullptr) {
+                probe.startDepth = depth;
+                probe.weight = weight;
+                probe.branches = countBranches(engine, depth);
+                if (probe.branches == 0) probe.control->addProgress(weight);
+            }
+            if (!searchFrom(engine, depth, workerVisit, probe) || !probe.flush()) {
+                stopped = true;
+            }
+        }
+
+        for (int d = depth - 1; d >= 0; --d) {
+            engine.unassign(d);
+        }
+    };
+
+    pool.submit([&expand](int w) { expand(w, {}, 1.0); });
+    pool.wait();
+#ifdef SUBGRAPH_SEARCH_STATS
+    if (options.stats != nullptr) {
+        for (const Engine& engine : engines) options.stats->merge(engine.stats);
+    }
+#endif
+    return !stopped;
+}
+
+// Обход всех сопоставлений движком; возвращает false, если visit остановил поиск
+template <typename Engine, typename Visitor>
+bool runEngine(const Engine& prototype, const SearchOptions& options, Visitor& visit) {
+    if (resolveThreads(options) == 1) {
+        Engine engine = prototype;
+        auto serialVisit = [&](const vector<int>& mapping) { return visit(0, mapping); };
+        ControlProbe probe;
+        probe.control = options.control;
+        if (probe.control != nullptr) {
+            probe.branches = countBranches(engine, 0);
+        }
+        bool completed = searchFrom(engine, 0, serialVisit, probe) && probe.flush();
+        SEARCH_STAT(if (options.stats != nullptr) options.stats->merge(engine.stats));
+        return completed;
+    }
+    return parallelSearch(prototype, options, visit);
+}
+
+// Паттерн из P вершин ищется движком, собранным под этот размер; больше
+// MAX_FIXED_PATTERN — движком с размером, известным только при выполнении
+template <int P, typename Target, typename Pattern, typename Visitor>
+bool runBacktrackEngine(const Target& target, const Pattern& pattern, const MatchPlan& plan,
+                        const CandidateDomains& domains, const SymmetryBounds& bounds,
+                        const SearchOptions& options, Visitor& visit) {
+    if constexpr (P > MAX_FIXED_PATTERN) {
+        return runEngine(BacktrackEngine<Target, Pattern>(target, pattern, plan, domains, bounds, options.semantics),
+                         options, visit);
+    } else {
+        if (pattern.getVertexCount() != P) {
+            return runBacktrackEngine<P + 1>(target, pattern, plan, domains, bounds, options, visit);
+        }
+        return runEngine(BacktrackEngine<Target, Pattern, P>(target, pattern, plan, domains, bounds,
+                                                             options.semantics),
+                         options, visit);
+    }
+}
+
+template <typename Target, typename Pattern, typename Visitor>
+bool runMatchEngine(const Target& target, const Pattern& pattern, const MatchPlan& plan,
+                    const CandidateDomains& domains, const SymmetryBounds& bounds,
+                    const SearchOptions& options, Visitor& visit) {
+    // Перебору с возвратом нужна плотная матрица; без неё работает VF2++
+    if (options.engine == MatchEngine::VF2pp || !target.hasAdjMatrix()) {
+        return runEngine(Vf2ppEngine<Target, Pattern>(target, pattern, plan, domains, bounds, options.semantics),
+                         options, visit);
+    }
+    return runBacktrackEngine<1>(target, pattern, plan, domains, bounds, options, visit);
+}
+
+// Семейство, вхождения которого ищутся ядром; General — общим движком. Ядра не
+// различают метки рёбер, а путь, цикл и звезда при гомоморфизме могут складываться
+// (клика — нет: петель в графе не бывает, и смежные вершины переходят в разные)
+template <typename Target, typename Pattern>
+PatternFamily choosePatternFamily(const Target& target, const Pattern& pattern, const SearchOptions& options) {
+    if (options.family == PatternFamily::General || pattern.hasEdgeLabels() || target.hasEdgeLabels()) {
+        return PatternFamily::General;
+    }
+    PatternFamily family = detectPatternFamily(pattern);
+    if (options.family != PatternFamily::Auto && options.family != family) return PatternFamily::General;
+    if (options.semantics == MatchSemantics::Homomorphism && family != PatternFamily::Clique) {
+        return PatternFamily::General;
+    }
+    return family;
+}
+
+// Наибольшее число раскладок паттерна на вхождение (|Aut| семейства), при котором
+// они перебираются готовым списком, а не поиском
+const int MAX_FAMILY_PLACEMENTS = 120;
+
+// Ядро для паттерна простого семейства: FamilyLister перечисляет вхождения, и паттерн
+// раскладывается на каждое всеми способами с проверкой меток и ограничений симметрии.
+// Выходят ровно те сопоставления, что нашёл бы общий движок: каждое переводит паттерн
+// ровно в одно вхождение, а вхождение выдаётся один раз. Домены не проверяются: их
+// фильтры необходимы для любого сопоставления, и структуру вхождение уже обеспечило
+template <typename Target, typename Pattern>
+class FamilyKernel {
+private:
+    const Target* target;
+    const MatchPlan* plan;
+    int k;
+    bool labelled;
+    vector<int> labels;                 // метки вершин паттерна
+    vector<pair<int, int>> ordered;     // образ first меньше образа second (снятие симметрии)
+    vector<char> linked;                // linked[i * k + j] — позиции i и j вхождения смежны
+    vector<vector<int>> placements;     // все раскладки: позиция образа каждой вершины паттерна
+    bool single;                        // ограничения пропускают ровно одну раскладку вхождения
+    size_t lastPlacement;               // подошедшая в прошлый раз — проверяется первой
+    FamilyLister<Target> lister;
+    vector<int> mapping;
+    vector<int> position;               // позиция образа вершины паттерна во вхождении
+    vector<char> taken;
+
+    // Раскладки паттерна на позиции вхождения в порядке плана; false — их больше limit
+    bool collectPlacements(int depth, size_t limit) {
+        if (depth == k) {
+            placements.push_back(position);
+            return placements.size() <= limit;
+        }
+        int u = plan->order[depth];
+        for (int p = 0; p < k; ++p) {
+            if (taken[p] || !fitsPosition(depth, p)) continue;
+            taken[p] = 1;
+            position[u] = p;
+            bool proceed = collectPlacements(depth + 1, limit);
+            taken[p] = 0;
+            if (!proceed) return false;
+        }
+        return true;
+    }
+
+    bool fitsPosition(int depth, int p) const {
+        for (int w : plan->backNeighbors[depth]) {
+            if (!linked[p * k + position[w]]) return false;
+        }
+        return true;
+    }
+
+    bool fitsLabel(int u, int v) const {
+        return !labelled || target->getVertexLabel(v) == labels[u];
+    }
+
+    // Поиск раскладок на вхождение, если готового списка нет
+    template <typename Visitor>
+    bool place(const vector<int>& occurrence, int depth, Visitor& visit) {
+        if (depth == k) {
+            SEARCH_STAT(stats.matches++);
+            return visit(mapping);
+        }
+        int u = plan->order[depth];
+        for (int p = 0; p < k; ++p) {
+            int v = occurrence[p];
+            if (taken[p] || !fitsLabel(u, v) || !fitsPosition(depth, p)) continue;
+            mapping[u] = v;
+            bool fits = true;
+            for (const auto& pair : ordered) {
+                if ((pair.first == u || pair.second == u) && position[pair.first == u ? pair.second : pair.first] >= 0 &&
+                    mapping[pair.first] >= mapping[pair.second]) {
+                    fits = false;
+                    break;
+                }
+            }
+            if (!fits) continue;
+            taken[p] = 1;
+            position[u] = p;
+            bool proceed = place(occurrence, depth + 1, visit);
+            taken[p] = 0;
+            position[u] = -1;
+            if (!proceed) return false;
+        }
+        return true;
+    }
+
+    bool fitsPlacement(const vector<int>& occurrence, const vector<int>& slots) {
+        for (const auto& pair : ordered) {
+            if (occurrence[slots[pair.first]] >= occurrence[slots[pair.second]]) return false;
+        }
+        for (int u = 0; u < k; ++u) {
+            mapping[u] = occurrence[slots[u]];
+            if (!fitsLabel(u, mapping[u])) return false;
+        }
+        return true;
+    }
+
+    template <typename Visitor>
+    bool placeAll(const vector<int>& occurrence, Visitor& visit) {
+        if (placements.empty()) return place(occurrence, 0, visit);
+        if (single) {
+            for (size_t t = 0; t < placements.size(); ++t) {
+                size_t i = (lastPlacement + t) % placements.size();
+                if (fitsPlacement(occurrence, placements[i])) {
+                    lastPlacement = i;
+                    SEARCH_STAT(stats.matches++);
+                    return visit(mapping);
+                }
+            }
+            return true;
+        }
+        for (const vector<int>& slots : placements) {
+            if (!fitsPlacement(occurrence, slots)) continue;
+            SEARCH_STAT(stats.matches++);
+            if (!visit(mapping)) return false;
+        }
+        return true;
+    }
+
+public:
+    SEARCH_STAT(SearchStats stats;)
+
+    FamilyKernel(const Target& targetGraph, const Pattern& pattern, PatternFamily family, const MatchPlan& matchPlan,
+                 const SymmetryBounds& bounds, MatchSemantics semantics, const vector<char>& allowed,
+                 const OrientedAdjacency* dag)
+        : target(&targetGraph), plan(&matchPlan), k(pattern.getVertexCount()),
+          labelled(pattern.hasVertexLabels() || targetGraph.hasVertexLabels()), labels(k),
+          linked((size_t)k * k), lister(targetGraph, family, k, semantics == MatchSemantics::Induced, allowed, dag),
+          mapping(k, -1), position(k, -1), taken(k, 0) {
+        for (int u = 0; u < k; ++u) labels[u] = pattern.getVertexLabel(u);
+        for (int depth = 0; depth < (int)bounds.greater.size(); ++depth) {
+            int u = plan->order[depth];
+            for (int w : bounds.greater[depth]) ordered.push_back({w, u});
+            for (int w : bounds.less[depth]) ordered.push_back({u, w});
+        }
+        for (int i = 0; i < k; ++i) {
+            for (int j = 0; j < k; ++j) {
+                linked[i * k + j] = familyLinked(family, k, i, j);
+            }
+        }
+        if (!collectPlacements(0, MAX_FAMILY_PLACEMENTS)) placements.clear();
+        fill(position.begin(), position.end(), -1);
+        // Без меток группа раскладок — Aut(P), и снятие симметрии оставляет из неё одну
+        single = !ordered.empty() && !labelled;
+        lastPlacement = 0;
+    }
+
+    // Все вхождения с корнем root
+    template <typename Visitor>
+    bool searchFrom(int root, Visitor& visit, ControlProbe& probe) {
+        auto tick = [&]() { return probe.tick(); };
+        auto emit = [&](const vector<int>& occurrence) {
+            SEARCH_STAT(stats.candidatesTried++);
+            return placeAll(occurrence, visit);
+        };
+        return lister.listFrom(root, emit, tick);
+    }
+};
+
+// Обход ядром семейства. В перечисление попадают только вершины графа со степенью не меньше
+// наименьшей в паттерне и с одной из его меток; корни делятся между исполнителями кусками
+template <typename Target, typename Pattern, typename Visitor>
+bool runFamilyKernel(const Target& target, const Pattern& pattern, PatternFamily family, const MatchPlan& plan,
+                     const SymmetryBounds& bounds, const SearchOptions& options, Visitor& visit) {
+    int V = target.getVertexCount();
+    int minDegree = V;
+    unordered_set<int> labels;
+    for (int u = 0; u < pattern.getVertexCount(); ++u) {
+        minDegree = min(minDegree, pattern.getDegree(u));
+        labels.insert(pattern.getVertexLabel(u));
+    }
+    bool labelled = pattern.hasVertexLabels() || target.hasVertexLabels();
+    vector<char> allowed(V, 0);
+    for (int v = 0; v < V; ++v) {
+        allowed[v] = target.getDegree(v) >= minDegree && (!labelled || labels.count(target.getVertexLabel(v)));
+    }
+    OrientedAdjacency dag;
+    if (family == PatternFamily::Clique) dag = orientByDegree(target, allowed);
+    FamilyKernel<Target, Pattern> prototype(target, pattern, family, plan, bounds, options.semantics, allowed, &dag);
+
+    int threads = resolveThreads(options);
+    if (threads == 1) {
+        auto serialVisit = [&](const vector<int>& mapping) { return visit(0, mapping); };
+        ControlProbe probe;
+        probe.control = options.control;
+        if (probe.control != nullptr) probe.branches = V;
+        bool completed = true;
+        for (int root = 0; root < V && completed; ++root) {
+            completed = prototype.searchFrom(root, serialVisit, probe);
+            if (completed) probe.branchDone(0);
+        }
+        completed = completed && probe.flush();
+        SEARCH_STAT(if (options.stats != nullptr) options.stats->merge(prototype.stats));
+        return completed;
+    }
+
+    WorkStealingPool pool(threads);
+    vector<FamilyKernel<Target, Pattern>> kernels(pool.size(), prototype);
+    atomic<bool> stopped(false);
+    int chunk = max(1, V / (pool.size() * 16));
+    for (int first = 0; first < V; first += chunk) {
+        pool.submit([&, first](int worker) {
+            if (stopped) return;
+            int last = min(V, first + chunk);
+            ControlProbe probe;
+            probe.control = options.control;
+            if (probe.control != nullptr) {
+                probe.weight = (double)(last - first) / V;
+                probe.branches = last - first;
+            }
+            auto workerVisit = [&](const vector<int>& mapping) {
+                if (stopped || !visit(worker, mapping)) {
+                    stopped = true;
+                    return false;
+                }
+                return true;
+            };
+            for (int root = first; root < last && !stopped; ++root) {
+                if (!kernels[worker].searchFrom(root, workerVisit, probe)) {
+                    stopped = true;
+                    break;
+                }
+                probe.branchDone(0);
+            }
+            if (!probe.flush()) stopped = true;
+        });
+    }
+    pool.wait();
+#ifdef SUBGRAPH_SEARCH_STATS
+    if (options.stats != nullptr) {
+        for (const auto& kernel : kernels) options.stats->merge(kernel.stats);
+    }
+#endif
+    return !stopped;
+}
+
+template <typename Target, typename Pattern, typename Visitor>
+bool subgraphVisit(const Target& target, const Pattern& pattern, const SearchOptions& options,
+                   Visitor& visit) {
+    if (options.control != nullptr) {
+        options.control->begin();
+    }
+    if (options.semantics != MatchSemantics::Homomorphism &&
+        pattern.getVertexCount() > target.getVertexCount()) {
+        if (options.control != nullptr) options.control->finish();
+        return true;
+    }
+    SEARCH_STAT(auto started = chrono::steady_clock::now());
+
+    MatchPlan ownPlan;
+    const MatchPlan* plan = options.plan;
+    if (plan == nullptr || (int)plan->order.size() != pattern.getVertexCount()) {
+        ownPlan = buildMatchPlan(target, pattern, options.targetIndex);
+        plan = &ownPlan;
+    }
+
+    // Ядру семейства домены не нужны: вхождения оно строит само, а метки проверяет при раскладке
+    PatternFamily family = choosePatternFamily(target, pattern, options);
+    CandidateDomains domains;
+    bool feasible = family != PatternFamily::General ||
+                    buildCandidateDomains(target, pattern, options.semantics, domains, options.targetIndex);
+
+    SymmetryBounds bounds;
+    PatternSymmetry ownSymmetry;
+    const PatternSymmetry* symmetry = nullptr;
+    if (feasible && breaksSymmetry(options)) {
+        symmetry = options.automorphisms;
+        if (symmetry == nullptr) {
+            // База цепочки идёт в порядке плана, чтобы ограничения проверялись как можно раньше
+            ownSymmetry = buildPatternSymmetry(pattern, &plan->order);
+            symmetry = &ownSymmetry;
+        }
+        bounds = buildSymmetryBounds(*plan, *symmetry);
+    }
+#ifdef SUBGRAPH_SEARCH_STATS
+    if (options.stats != nullptr) {
+        options.stats->merge(domains.stats);
+        options.stats->preprocessSeconds += secondsSince(started);
+    }
+#endif
+    if (!feasible || (options.control != nullptr && !options.control->addNodes(0))) {
+        if (options.control != nullptr) options.control->finish();
+        return !feasible;
+    }
+
+    bool expand = symmetry != nullptr && options.symmetry == SymmetryMode::Expand && !symmetry->base.empty();
+    SEARCH_STAT(vector<double> outputSeconds(resolveThreads(options), 0.0));
+    auto deliver = [&](int worker, const vector<int>& mapping) {
+        SEARCH_STAT(auto delivered = chrono::steady_clock::now());
+        bool proceed;
+        if (expand) {
+            vector<vector<int>> current(symmetry->base.size() + 1);
+            current[0] = mapping;
+            auto emit = [&](const vector<int>& expanded) { return visit(worker, expanded); };
+            proceed = expandSymmetry(*symmetry, 0, current, emit);
+        } else {
+            proceed = visit(worker, mapping);
+        }
+        SEARCH_STAT(outputSeconds[worker] += secondsSince(delivered));
+        return proceed;
+    };
+
+    SEARCH_STAT(auto searchStarted = chrono::steady_clock::now());
+    bool completed = family != PatternFamily::General
+        ? runFamilyKernel(target, pattern, family, *plan, bounds, options, deliver)
+        : runMatchEngine(target, pattern, *plan, domains, bounds, options, deliver);
+    if (options.control != nullptr) {
+        options.control->finish();
+    }
+#ifdef SUBGRAPH_SEARCH_STATS
+    if (options.stats != nullptr) {
+        options.stats->searchSeconds += secondsSince(searchStarted);
+        for (double seconds : outputSeconds) options.stats->outputSeconds += seconds;
+    }
+#endif
+    return completed;
+}
+
+// Копия options с заполненными plan и automorphisms (свои хранятся в ownPlan, ownSymmetry)
+template <typename Target, typename Pattern>
+SearchOptions prepareSymmetry(const Target& target, const Pattern& pattern, const SearchOptions& options,
+                              MatchPlan& ownPlan, PatternSymmetry& ownSymmetry) {
+    SearchOptions prepared = options;
+    if (prepared.plan == nullptr || (int)prepared.plan->order.size() != pattern.getVertexCount()) {
+        ownPlan = buildMatchPlan(target, pattern, options.targetIndex);
+        prepared.plan = &ownPlan;
+    }
+    if (prepared.automorphisms == nullptr) {
+        ownSymmetry = buildPatternSymmetry(pattern, &prepared.plan->order);
+        prepared.automorphisms = &ownSymmetry;
+    }
+    return prepared;
+}
+
+template <typename Target, typename Pattern>
+vector<vector<int>> subgraphSearch(const Target& target, const Pattern& pattern,
+                                   const SearchOptions& options) {
+    // Свой буфер на исполнителя, без блокировок
+    vector<vector<vector<int>>> results(resolveThreads(options));
+    auto collect = [&](int worker, const vector<int>& mapping) {
+        results[worker].push_back(mapping);
+        return true;
+    };
+    subgraphVisit(target, pattern, options, collect);
+
+    SEARCH_STAT(auto merging = chrono::steady_clock::now());
+    vector<vector<int>> allMappings = move(results[0]);
+    for (size_t i = 1; i < results.size(); ++i) {
+        allMappings.insert(allMappings.end(), make_move_iterator(results[i].begin()),
+                           make_move_iterator(results[i].end()));
+    }
+    if (results.size() > 1) {
+        // Порядок результатов не зависит от распределения задач по потокам
+        sort(allMappings.begin(), allMappings.end());
+    }
+    SEARCH_STAT(if (options.stats != nullptr) options.stats->outputSeconds += secondsSince(merging));
+    return allMappings;
+}
+
+// Подсчёт без сохранения сопоставлений; у каждого исполнителя свой счётчик
+// в отдельной кэш-линии
+template <typename Target, typename Pattern>
+uint64_t subgraphCount(const Target& target, const Pattern& pattern, const SearchOptions& options) {
+    if (options.symmetry == SymmetryMode::Expand && breaksSymmetry(options)) {
+        // Раскрывать не нужно: каждый класс содержит ровно |Aut(P)| сопоставлений
+        MatchPlan ownPlan;
+        PatternSymmetry ownSymmetry;
+        SearchOptions broken = prepareSymmetry(target, pattern, options, ownPlan, ownSymmetry);
+        broken.symmetry = SymmetryMode::Break;
+        return subgraphCount(target, pattern, broken) * broken.automorphisms->automorphisms;
+    }
+
+    struct alignas(64) Counter {
+        uint64_t value = 0;
+    };
+    vector<Counter> counters(resolveThreads(options));
+    auto count = [&](int worker, const vector<int>&) {
+        counters[worker].value++;
+        return true;
+    };
+    subgraphVisit(target, pattern, options, count);
+
+    uint64_t total = 0;
+    for (const auto& counter : counters) {
+        total += counter.value;
+    }
+    return total;
+}
+
+struct VertexSetHash {
+    size_t operator()(const vector<int>& vertices) const {
+        uint64_t hash = 1469598103934665603ull;
+        for (int v : vertices) {
+            hash = (hash ^ (uint32_t)v) * 1099511628211ull;
+        }
+        return (size_t)hash;
+    }
+};
+
+template <typename Target, typename Pattern>
+MatchCount subgraphCountMatches(const Target& target, const Pattern& pattern,
+                                const SearchOptions& options, bool distinctVertexSets) {
+    MatchCount result;
+    if (!distinctVertexSets) {
+        result.mappings = subgraphCount(target, pattern, options);
+        return result;
+    }
+
+    MatchPlan ownPlan;
+    PatternSymmetry ownSymmetry;
+    SearchOptions prepared = options;
+    if (options.semantics == MatchSemantics::Induced || breaksSymmetry(options)) {
+        prepared = prepareSymmetry(target, pattern, options, ownPlan, ownSymmetry);
+    }
+
+    // Индуцированный подграф на одном множестве вершин даёт ровно |Aut(P)| сопоставлений,
+    // то есть один класс
+    if (options.semantics == MatchSemantics::Induced) {
+        uint64_t automorphisms = prepared.automorphisms->automorphisms;
+        if (options.symmetry == SymmetryMode::None) {
+            result.mappings = subgraphCount(target, pattern, prepared);
+            result.vertexSets = result.mappings / automorphisms;
+        } else {
+            prepared.symmetry = SymmetryMode::Break;
+            result.vertexSets = subgraphCount(target, pattern, prepared);
+            result.mappings = options.symmetry == SymmetryMode::Break
+                ? result.vertexSets : result.vertexSets * automorphisms;
+        }
+        return result;
+    }
+
+    // Иначе на одном множестве вершин может быть несколько классов, и множества
+    // собираются явно; весь класс f∘Aut(P) занимает одно множество, так что
+    // при снятии симметрии хватает его представителя
+    struct alignas(64) Collector {
+        uint64_t found = 0;
+        unordered_set<vector<int>, VertexSetHash> sets;
+    };
+    vector<Collector> collectors(resolveThreads(options));
+    auto collect = [&](int worker, const vector<int>& mapping) {
+        vector<int> vertices = mapping;
+        sort(vertices.begin(), vertices.end());
+        vertices.erase(unique(vertices.begin(), vertices.end()), vertices.end());
+        collectors[worker].found++;
+        collectors[worker].sets.insert(move(vertices));
+        return true;
+    };
+    bool expand = breaksSymmetry(options) && options.symmetry == SymmetryMode::Expand;
+    if (expand) {
+        prepared.symmetry = SymmetryMode::Break;
+    }
+    subgraphVisit(target, pattern, prepared, collect);
+
+    uint64_t found = collectors[0].found;
+    for (size_t i = 1; i < collectors.size(); ++i) {
+        found += collectors[i].found;
+        collectors[0].sets.insert(collectors[i].sets.begin(), collectors[i].sets.end());
+    }
+    result.mappings = expand ? found * prepared.automorphisms->automorphisms : found;
+    result.vertexSets = collectors[0].sets.size();
+    return result;
+}
+
+// Потоковый обход: visitor вызывается по одному разу на найденное сопоставление,
+// при нескольких потоках вызовы сериализуются
+template <typename Target, typename Pattern>
+bool subgraphStream(const Target& target, const Pattern& pattern, const SearchOptions& options,
+                    const MatchVisitor& visitor) {
+    mutex visitLock;
+    bool stopped = false;
+    auto visit = [&](int, const vector<int>& mapping) {
+        lock_guard<mutex> guard(visitLock);
+        if (stopped) return false;
+        stopped = !visitor(mapping);
+        return !stopped;
+    };
+    return subgraphVisit(target, pattern, options, visit);
+}
+
+template <typename Target, typename Pattern>
+bool subgraphFindFirst(const Target& target, const Pattern& pattern, vector<int>& mapping,
+                       const SearchOptions& options) {
+    bool found = false;
+    subgraphStream(target, pattern, options, [&](const vector<int>& m) {
+        mapping = m;
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+template <typename Target, typename Pattern>
+vector<vector<int>> subgraphFindK(const Target& target, const Pattern& pattern, size_t k,
+                                  const SearchOptions& options) {
+    vector<vector<int>> mappings;
+    if (k == 0) {
+        return mappings;
+    }
+    subgraphStream(target, pattern, options, [&](const vector<int>& m) {
+        mappings.push_back(m);
+        return mappings.size() < k;
+    });
+    return mappings;
+}
+
+#endif
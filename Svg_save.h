@@ -2,11 +2,91 @@
 #define SVG_SAVE_H
 
 #include "Graph.h"
+#include "Csr_graph.h"
 #include <fstream>
 #include <cmath>
+#include <cstdio>
+#include <random>
 
 using namespace std;
 
+enum class SvgLayout {
+    Circle,     // вершины по окружности
+    Force       // силовая раскладка, отталкивание по Barnes–Hut за O(V log V) на шаг
+};
+
+struct SvgExportOptions {
+    int width = 1200;
+    int height = 900;
+    SvgLayout layout = SvgLayout::Force;
+    int iterations = 100;       // шагов силовой раскладки
+    double theta = 0.8;         // точность Barnes–Hut: больше — быстрее и грубее
+    size_t maxMatches = 16;     // сколько первых сопоставлений рисовать слоями (0 — все)
+    int maxVertices = 2000;     // при большем графе рисуется выборка вокруг сопоставлений
+    int maxLabels = 100;        // номера вершин подписываются, только если вершин не больше
+    uint64_t seed = 1;
+};
+
+// Буферизованная запись SVG: текст копится в одном буфере и сбрасывается в файл
+// большими блоками вместо отдельной записи на каждый элемент
+class SvgWriter {
+private:
+    FILE* file;
+    string buffer;
+    size_t capacity;
+
+public:
+    explicit SvgWriter(const string& filename, size_t bufferBytes = 1 << 20)
+        : file(fopen(filename.c_str(), "wb")), capacity(bufferBytes) {
+        buffer.reserve(capacity + 256);
+    }
+    ~SvgWriter() { close(); }
+    SvgWriter(const SvgWriter&) = delete;
+    SvgWriter& operator=(const SvgWriter&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+
+    SvgWriter& operator<<(const char* text) {
+        buffer += text;
+        return flushIfFull();
+    }
+    SvgWriter& operator<<(const string& text) {
+        buffer += text;
+        return flushIfFull();
+    }
+    SvgWriter& operator<<(int64_t value) {
+        char number[24];
+        buffer.append(number, snprintf(number, sizeof(number), "%lld", (long long)value));
+        return flushIfFull();
+    }
+    SvgWriter& operator<<(int value) { return *this << (int64_t)value; }
+    SvgWriter& operator<<(size_t value) { return *this << (int64_t)value; }
+    // Координаты — с одним знаком после запятой
+    SvgWriter& operator<<(double value) {
+        char number[32];
+        buffer.append(number, snprintf(number, sizeof(number), "%.1f", value));
+        return flushIfFull();
+    }
+
+    SvgWriter& flushIfFull() {
+        if (buffer.size() >= capacity) flush();
+        return *this;
+    }
+    void flush() {
+        if (file != nullptr && !buffer.empty()) fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+    // false — запись не удалась
+    bool close() {
+        if (file == nullptr) return false;
+        flush();
+        bool ok = ferror(file) == 0;
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+};
+
 class GraphVisualizer {
 private:
     struct Point {
@@ -19,8 +99,26 @@ private:
         return Point(centerX + radius * cos(angle), centerY + radius * sin(angle));
     }
     
+    // Узел дерева квадрантов: сумма координат и число точек внутри квадрата со стороной 2 * half
+    struct QuadNode {
+        double cx, cy, half;
+        double mass = 0, sumX = 0, sumY = 0;
+        int child = -1;     // первый из четырёх потомков, -1 — лист
+        int body = -1;      // точка листа
+    };
+    
+    static void quadInsert(vector<QuadNode>& nodes, const vector<Point>& points, int body);
+    static vector<Point> forceLayout(const vector<vector<int>>& adjacency, const SvgExportOptions& options);
+    
+    // Цвет слоя: соседние слои расходятся по оттенку на золотой угол
+    static string layerColor(size_t layer) {
+        return "hsl(" + to_string((int)fmod(layer * 137.508, 360.0)) + ",75%,45%)";
+    }
+    
 public:
-    static void saveGraphToSVG(const Graph& graph, const string& filename, int width = 600, int height = 300) {
+    // Основной граф может быть Graph или CsrGraph: рёбра берутся из списков смежности
+    template <typename G>
+    static void saveGraphToSVG(const G& graph, const string& filename, int width = 600, int height = 300) {
         ofstream svg(filename);
         if (!svg.is_open()) {
             cerr << "Ошибка создания SVG файла\n";
@@ -38,10 +136,9 @@ public:
         
         // Рёбра
         svg << "  <!-- Рёбра графа -->\n";
-        const auto& adjMatrix = graph.getAdjMatrix();
         for (int i = 0; i < V; ++i) {
-            for (int j = i + 1; j < V; ++j) {
-                if (adjMatrix[i][j]) {
+            for (int j : graph.getNeighbors(i)) {
+                if (j > i) {
                     Point p1 = getCirclePoint(i, V, radius, centerX, centerY);
                     Point p2 = getCirclePoint(j, V, radius, centerX, centerY);
                     svg << "  <line x1=\"" << p1.x << "\" y1=\"" << p1.y 
@@ -73,7 +170,8 @@ public:
         cout << "Граф сохранён в " << filename << "\n";
     }
     
-    static void saveComparisonToSVG(const Graph& mainGraph, const Graph& pattern, 
+    template <typename G>
+    static void saveComparisonToSVG(const G& mainGraph, const Graph& pattern, 
                                    const vector<int>& mapping, const string& filename, 
                                    int width = 800, int height = 400) {
         ofstream svg(filename);
@@ -96,10 +194,9 @@ public:
         
         // ИСХОДНЫЙ ГРАФ
         svg << "  <!-- Рёбра исходного графа -->\n";
-        const auto& mainAdjMatrix = mainGraph.getAdjMatrix();
         for (int i = 0; i < mainV; ++i) {
-            for (int j = i + 1; j < mainV; ++j) {
-                if (mainAdjMatrix[i][j]) {
+            for (int j : mainGraph.getNeighbors(i)) {
+                if (j > i) {
                     Point p1 = getCirclePoint(i, mainV, radius, leftCenterX, centerY);
                     Point p2 = getCirclePoint(j, mainV, radius, leftCenterX, centerY);
                     svg << "  <line x1=\"" << p1.x << "\" y1=\"" << p1.y 
@@ -111,10 +208,9 @@ public:
         
         // Подсветка найденного подграфа в основном графе
         svg << "  <!-- Выделенный изоморфный подграф -->\n";
-        const auto& patternAdjMatrix = pattern.getAdjMatrix();
         for (int i = 0; i < patternV; ++i) {
             for (int j = i + 1; j < patternV; ++j) {
-                if (patternAdjMatrix[i][j]) {
+                if (pattern.hasEdge(i, j)) {
                     int u = mapping[i];
                     int v = mapping[j];
                     Point p1 = getCirclePoint(u, mainV, radius, leftCenterX, centerY);
@@ -128,17 +224,11 @@ public:
         
         // Вершины исходного графа
         svg << "  <!-- Вершины исходного графа -->\n";
+        vector<char> inPattern(mainV, 0);
+        for (int v : mapping) inPattern[v] = 1;
         for (int i = 0; i < mainV; ++i) {
             Point p = getCirclePoint(i, mainV, radius, leftCenterX, centerY);
-            bool isInPattern = false;
-            for (int j = 0; j < patternV; ++j) {
-                if (mapping[j] == i) {
-                    isInPattern = true;
-                    break;
-                }
-            }
-            
-            string fillColor = isInPattern ? "red" : "lightblue";
+            string fillColor = inPattern[i] ? "red" : "lightblue";
             svg << "  <circle cx=\"" << p.x << "\" cy=\"" << p.y 
                 << "\" r=\"15\" fill=\"" << fillColor 
                 << "\" stroke=\"black\" stroke-width=\"2\"/>\n";
@@ -151,7 +241,7 @@ public:
         svg << "  <!-- Рёбра изоморфного подграфа -->\n";
         for (int i = 0; i < patternV; ++i) {
             for (int j = i + 1; j < patternV; ++j) {
-                if (patternAdjMatrix[i][j]) {
+                if (pattern.hasEdge(i, j)) {
                     Point p1 = getCirclePoint(i, patternV, radius, rightCenterX, centerY);
                     Point p2 = getCirclePoint(j, patternV, radius, rightCenterX, centerY);
                     svg << "  <line x1=\"" << p1.x << "\" y1=\"" << p1.y 
@@ -201,6 +291,289 @@ public:
         
         cout << "Сравнение сохранено в " << filename << "\n";
     }
+    
+    // Несколько сопоставлений слоями разных цветов на одном графе. Для графа больше
+    // options.maxVertices рисуется выборка: вершины сопоставлений, их соседи, затем
+    // случайные вершины до предела. Рёбра берутся из списков смежности. Возвращает false,
+    // если файл не записан
+    template <typename G>
+    static bool saveMatchesToSVG(const G& mainGraph, const Graph& pattern, const vector<vector<int>>& mappings,
+                                 const string& filename, const SvgExportOptions& options = SvgExportOptions()) {
+        SvgWriter svg(filename);
+        if (!svg.isOpen()) {
+            cerr << "Ошибка создания SVG файла\n";
+            return false;
+        }
+        
+        int mainV = mainGraph.getVertexCount();
+        size_t layers = options.maxMatches == 0 ? mappings.size() : min(mappings.size(), options.maxMatches);
+        
+        // Выборка вершин: local[v] — номер вершины в рисунке или -1
+        vector<int> shown;
+        vector<int> local(mainV, -1);
+        vector<int> firstLayer(mainV, -1);
+        int limit = max(options.maxVertices, 1);
+        auto show = [&](int v) {
+            if (local[v] < 0 && (int)shown.size() < limit) {
+                local[v] = (int)shown.size();
+                shown.push_back(v);
+            }
+        };
+        for (size_t layer = 0; layer < layers; ++layer) {
+            for (int v : mappings[layer]) {
+                if (firstLayer[v] < 0) firstLayer[v] = (int)layer;
+                show(v);
+            }
+        }
+        if (mainV <= limit) {
+            for (int v = 0; v < mainV; ++v) show(v);
+        } else {
+            for (size_t i = 0; i < shown.size() && (int)shown.size() < limit; ++i) {
+                for (int w : mainGraph.getNeighbors(shown[i])) show(w);
+            }
+            mt19937_64 gen(options.seed);
+            uniform_int_distribution<int> pick(0, mainV - 1);
+            for (int attempt = 0; (int)shown.size() < limit && attempt < 4 * limit; ++attempt) show(pick(gen));
+        }
+        
+        int n = (int)shown.size();
+        vector<vector<int>> adjacency(n);
+        int64_t shownEdges = 0;
+        for (int i = 0; i < n; ++i) {
+            for (int w : mainGraph.getNeighbors(shown[i])) {
+                if (local[w] > i) {
+                    adjacency[i].push_back(local[w]);
+                    adjacency[local[w]].push_back(i);
+                    ++shownEdges;
+                }
+            }
+        }
+        
+        vector<Point> points;
+        if (options.layout == SvgLayout::Force) {
+            points = forceLayout(adjacency, options);
+        } else {
+            double radius = min(options.width, options.height) * 0.4;
+            for (int i = 0; i < n; ++i) {
+                points.push_back(getCirclePoint(i, n, radius, options.width * 0.5, options.height * 0.5 + 30));
+            }
+        }
+        double vertexRadius = max(2.0, min(12.0, 400.0 / sqrt((double)max(n, 1))));
+        
+        svg << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        svg << "<svg width=\"" << options.width << "\" height=\"" << options.height + 60 << "\" "
+            << "xmlns=\"http://www.w3.org/2000/svg\">\n";
+        svg << "  <rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+        
+        // Общие атрибуты — на группе, чтобы не повторять их в каждом элементе
+        svg << "  <g stroke=\"#b0b0b0\" stroke-width=\"1\">\n";
+        for (int i = 0; i < n; ++i) {
+            for (int j : adjacency[i]) {
+                if (j > i) {
+                    svg << "    <line x1=\"" << points[i].x << "\" y1=\"" << points[i].y
+                        << "\" x2=\"" << points[j].x << "\" y2=\"" << points[j].y << "\"/>\n";
+                }
+            }
+        }
+        svg << "  </g>\n";
+        
+        for (size_t layer = 0; layer < layers; ++layer) {
+            const vector<int>& mapping = mappings[layer];
+            svg << "  <g stroke=\"" << layerColor(layer) << "\" stroke-width=\"3\" stroke-opacity=\"0.8\">\n";
+            for (int a = 0; a < pattern.getVertexCount(); ++a) {
+                for (int b : pattern.getNeighbors(a)) {
+                    int u = local[mapping[a]];
+                    int v = local[mapping[b]];
+                    if (a < b && u >= 0 && v >= 0) {
+                        svg << "    <line x1=\"" << points[u].x << "\" y1=\"" << points[u].y
+                            << "\" x2=\"" << points[v].x << "\" y2=\"" << points[v].y << "\"/>\n";
+                    }
+                }
+            }
+            svg << "  </g>\n";
+        }
+        
+        svg << "  <g stroke=\"black\" stroke-width=\"1\">\n";
+        for (int i = 0; i < n; ++i) {
+            int layer = firstLayer[shown[i]];
+            svg << "    <circle cx=\"" << points[i].x << "\" cy=\"" << points[i].y << "\" r=\"" << vertexRadius
+                << "\" fill=\"" << (layer >= 0 ? layerColor(layer) : string("lightblue")) << "\"/>\n";
+        }
+        svg << "  </g>\n";
+        if (n <= options.maxLabels) {
+            svg << "  <g text-anchor=\"middle\" font-size=\"11\">\n";
+            for (int i = 0; i < n; ++i) {
+                svg << "    <text x=\"" << points[i].x << "\" y=\"" << points[i].y + 4 << "\">" << shown[i] << "</text>\n";
+            }
+            svg << "  </g>\n";
+        }
+        
+        // Заголовок
+        svg << "  <text x=\"" << options.width / 2 << "\" y=\"24\" text-anchor=\"middle\" "
+            << "font-size=\"16\" font-weight=\"bold\">" << mainV << " вершин, "
+            << (int64_t)mainGraph.getEdgeCount() << " рёбер; сопоставлений " << layers << " из "
+            << mappings.size() << "</text>\n";
+        if (n < mainV) {
+            svg << "  <text x=\"" << options.width / 2 << "\" y=\"44\" text-anchor=\"middle\" "
+                << "font-size=\"13\">Выборка: " << n << " вершин, " << shownEdges << " рёбер</text>\n";
+        }
+        
+        svg << "</svg>\n";
+        if (!svg.close()) {
+            cerr << "Ошибка записи SVG файла\n";
+            return false;
+        }
+        cout << "Сопоставления сохранены в " << filename << "\n";
+        return true;
+    }
 };
 
+inline void GraphVisualizer::quadInsert(vector<QuadNode>& nodes, const vector<Point>& points, int body) {
+    const Point& p = points[body];
+    int node = 0;
+    while (true) {
+        if (nodes[node].child < 0 && nodes[node].mass == 0) {
+            nodes[node].body = body;
+            nodes[node].mass = 1;
+            nodes[node].sumX = p.x;
+            nodes[node].sumY = p.y;
+            return;
+        }
+        if (nodes[node].child < 0) {
+            // Совпадающие точки не делятся бесконечно: лист просто набирает массу
+            if (nodes[node].half < 1e-3) {
+                nodes[node].mass += 1;
+                nodes[node].sumX += p.x;
+                nodes[node].sumY += p.y;
+                return;
+            }
+            int first = (int)nodes.size();
+            double half = nodes[node].half / 2;
+            for (int q = 0; q < 4; ++q) {
+                QuadNode child;
+                child.cx = nodes[node].cx + (q & 1 ? half : -half);
+                child.cy = nodes[node].cy + (q & 2 ? half : -half);
+                child.half = half;
+                nodes.push_back(child);
+            }
+            int old = nodes[node].body;
+            const Point& o = points[old];
+            int q = (o.x >= nodes[node].cx) | (o.y >= nodes[node].cy) << 1;
+            nodes[first + q].body = old;
+            nodes[first + q].mass = 1;
+            nodes[first + q].sumX = o.x;
+            nodes[first + q].sumY = o.y;
+            nodes[node].child = first;
+            nodes[node].body = -1;
+        }
+        nodes[node].mass += 1;
+        nodes[node].sumX += p.x;
+        nodes[node].sumY += p.y;
+        node = nodes[node].child + ((p.x >= nodes[node].cx) | (p.y >= nodes[node].cy) << 1);
+    }
+}
+
+// Фрухтерман — Рейнгольд: притяжение по рёбрам d^2 / k, отталкивание k^2 / d; дальние
+// группы вершин отталкивают как одна точка в их центре масс, если сторона квадрата
+// меньше theta * расстояние
+inline vector<GraphVisualizer::Point> GraphVisualizer::forceLayout(const vector<vector<int>>& adjacency,
+                                                                   const SvgExportOptions& options) {
+    int n = (int)adjacency.size();
+    double width = options.width, height = options.height;
+    vector<Point> points(n);
+    mt19937_64 gen(options.seed);
+    uniform_real_distribution<double> coord(0.0, 1.0);
+    for (Point& p : points) p = Point(coord(gen) * width, coord(gen) * height);
+    if (n <= 1) {
+        for (Point& p : points) p = Point(width / 2, height / 2 + 30);
+        return points;
+    }
+    
+    double k = sqrt(width * height / n);
+    double k2 = k * k;
+    double theta2 = options.theta * options.theta;
+    vector<Point> shift(n);
+    vector<QuadNode> nodes;
+    vector<int> stack;
+    for (int iteration = 0; iteration < options.iterations; ++iteration) {
+        double temperature = width / 10 * (1 - (double)iteration / options.iterations);
+        
+        double minX = points[0].x, maxX = minX, minY = points[0].y, maxY = minY;
+        for (const Point& p : points) {
+            minX = min(minX, p.x);
+            maxX = max(maxX, p.x);
+            minY = min(minY, p.y);
+            maxY = max(maxY, p.y);
+        }
+        nodes.clear();
+        QuadNode root;
+        root.cx = (minX + maxX) / 2;
+        root.cy = (minY + maxY) / 2;
+        root.half = max(maxX - minX, maxY - minY) / 2 + 1;
+        nodes.push_back(root);
+        for (int i = 0; i < n; ++i) quadInsert(nodes, points, i);
+        
+        for (int i = 0; i < n; ++i) {
+            double fx = 0, fy = 0;
+            stack.assign(1, 0);
+            while (!stack.empty()) {
+                const QuadNode& node = nodes[stack.back()];
+                stack.pop_back();
+                if (node.mass == 0 || (node.child < 0 && node.body == i && node.mass == 1)) continue;
+                double dx = points[i].x - node.sumX / node.mass;
+                double dy = points[i].y - node.sumY / node.mass;
+                double d2 = dx * dx + dy * dy;
+                if (node.child < 0 || 4 * node.half * node.half < theta2 * d2) {
+                    if (d2 < 1e-6) {
+                        // Совпадающие точки расталкиваются в случайную сторону
+                        dx = coord(gen) - 0.5;
+                        dy = coord(gen) - 0.5;
+                        d2 = dx * dx + dy * dy + 1e-9;
+                    }
+                    fx += dx / d2 * k2 * node.mass;
+                    fy += dy / d2 * k2 * node.mass;
+                } else {
+                    for (int q = 0; q < 4; ++q) stack.push_back(node.child + q);
+                }
+            }
+            shift[i] = Point(fx, fy);
+        }
+        for (int i = 0; i < n; ++i) {
+            for (int j : adjacency[i]) {
+                if (j < i) continue;
+                double dx = points[i].x - points[j].x;
+                double dy = points[i].y - points[j].y;
+                double d = sqrt(dx * dx + dy * dy) + 1e-9;
+                double f = d / k;
+                shift[i].x -= dx * f;
+                shift[i].y -= dy * f;
+                shift[j].x += dx * f;
+                shift[j].y += dy * f;
+            }
+        }
+        for (int i = 0; i < n; ++i) {
+            double d = sqrt(shift[i].x * shift[i].x + shift[i].y * shift[i].y) + 1e-9;
+            double step = min(d, temperature);
+            points[i].x += shift[i].x / d * step;
+            points[i].y += shift[i].y / d * step;
+        }
+    }
+    
+    // Вписывание в кадр с полями; сверху место под заголовок
+    double minX = points[0].x, maxX = minX, minY = points[0].y, maxY = minY;
+    for (const Point& p : points) {
+        minX = min(minX, p.x);
+        maxX = max(maxX, p.x);
+        minY = min(minY, p.y);
+        maxY = max(maxY, p.y);
+    }
+    double margin = 20;
+    double scale = min((width - 2 * margin) / max(maxX - minX, 1e-9), (height - 2 * margin) / max(maxY - minY, 1e-9));
+    for (Point& p : points) {
+        p.x = margin + (p.x - minX) * scale;
+        p.y = 60 + margin + (p.y - minY) * scale;
+    }
+    return points;
+}
+
 #endif
\ No newline at end of file
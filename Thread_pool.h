@@ -0,0 +1,154 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Пул потоков с перехватом работы: у каждого исполнителя своя очередь,
+// свои задачи он берёт с конца, чужие — с начала
+class WorkStealingPool {
+public:
+    using Task = function<void(int)>;   // аргумент — номер исполнителя
+
+    explicit WorkStealingPool(int threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int size() const { return (int)workers.size(); }
+
+    // Из потока-исполнителя задача попадает в его очередь, иначе — по кругу
+    void submit(Task task);
+    // Ожидание завершения всех задач, включая порождённые во время работы
+    void wait();
+
+private:
+    struct Queue {
+        mutex lock;
+        deque<Task> tasks;
+    };
+
+    vector<unique_ptr<Queue>> queues;
+    vector<thread> workers;
+
+    mutex sleepLock;
+    condition_variable wakeUp;
+    condition_variable idle;
+    atomic<int> pending;    // отправлено, но ещё не выполнено
+    atomic<int> queued;     // лежит в очередях
+    atomic<unsigned> nextQueue;
+    bool stopping;
+
+    static int& workerIndex() {
+        static thread_local int index = -1;
+        return index;
+    }
+    static const WorkStealingPool*& workerPool() {
+        static thread_local const WorkStealingPool* pool = nullptr;
+        return pool;
+    }
+
+    bool tryPop(int self, Task& task);
+    void workerLoop(int self);
+};
+
+inline WorkStealingPool::WorkStealingPool(int threads)
+    : pending(0), queued(0), nextQueue(0), stopping(false) {
+    if (threads < 1) threads = 1;
+    for (int i = 0; i < threads; ++i) {
+        queues.push_back(make_unique<Queue>());
+    }
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+inline WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+inline void WorkStealingPool::submit(Task task) {
+    int target = workerPool() == this ? workerIndex()
+                                      : (int)(nextQueue++ % queues.size());
+    // Счётчик растёт до публикации задачи, иначе её могут выполнить
+    // и обнулить pending раньше, чем закончится породившая её задача
+    pending++;
+    {
+        lock_guard<mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(move(task));
+    }
+    {
+        lock_guard<mutex> guard(sleepLock);
+        queued++;
+    }
+    wakeUp.notify_one();
+}
+
+inline void WorkStealingPool::wait() {
+    unique_lock<mutex> guard(sleepLock);
+    idle.wait(guard, [this] { return pending == 0; });
+}
+
+inline bool WorkStealingPool::tryPop(int self, Task& task) {
+    {
+        Queue& own = *queues[self];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    int n = (int)queues.size();
+    for (int k = 1; k < n; ++k) {
+        Queue& victim = *queues[(self + k) % n];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void WorkStealingPool::workerLoop(int self) {
+    workerIndex() = self;
+    workerPool() = this;
+
+    while (true) {
+        Task task;
+        if (tryPop(self, task)) {
+            task(self);
+            if (--pending == 0) {
+                lock_guard<mutex> guard(sleepLock);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        unique_lock<mutex> guard(sleepLock);
+        wakeUp.wait(guard, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+#endif
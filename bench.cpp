@@ -0,0 +1,534 @@
+// Неинтерактивный замер производительности поиска подграфов.
+// Сборка: g++ -std=c++17 -O2 -pthread bench.cpp -o bench
+// Пример:  ./bench --vertices=100,200 --pattern=4,5 --density=0.2 --family=random,clique
+//                  --engine=backtracking,vf2pp --seeds=3 --repeat=7 --format=csv --output=base.csv
+#include "Graph.h"
+#include "Csr_graph.h"
+#include "Graph_io.h"
+#include <fstream>
+#include <iostream>
+#include <map>
+
+using namespace std;
+
+struct BenchConfig {
+    vector<int> vertices = {50, 100};
+    vector<int> patternSizes = {4, 6};
+    vector<double> densities = {0.1, 0.3};
+    vector<string> models = {"gnp"};
+    double patternDensity = -1;     // < 0 — как у основного графа
+    vector<string> families = {"random", "planted", "clique", "cycle"};
+    vector<string> engines = {"backtracking", "vf2pp"};
+    vector<string> semantics = {"induced"};
+    vector<string> symmetry = {"none"};
+    vector<string> storage = {"graph"};
+    vector<string> reorders = {"none"};
+    vector<string> kernels = {"auto"};
+    vector<string> modes = {"count"};
+    vector<int> threads = {1};
+    int seeds = 3;
+    uint64_t baseSeed = 1;
+    int warmup = 1;
+    int repeat = 5;
+    int timeLimitMs = 0;            // 0 — без ограничения
+    uint64_t samples = 1000;        // выборок на запуск в режиме estimate
+    string format = "json";
+    string output;                  // пусто — стандартный вывод
+    string input;                   // файл основного графа вместо случайного
+};
+
+struct BenchResult {
+    int vertices;
+    int64_t edges;
+    int patternSize;
+    int patternEdges;
+    double density;
+    string model;
+    string family;
+    string engine;
+    string semantics;
+    string symmetry;
+    string storage;
+    string reorder;
+    double reorderMs;               // перенумерация, один раз на граф; в замеры не входит
+    string kernel;                  // auto — ядра семейств паттернов, general — только общий движок
+    string mode;
+    int threads;
+    uint64_t seed;
+    uint64_t matches;
+    string status;                  // completed или причина остановки последнего запуска
+    int runs;
+    double minMs;
+    double medianMs;
+    double p95Ms;
+    double meanMs;
+};
+
+void printUsage();
+bool parseArguments(int argc, char* argv[], BenchConfig& config);
+bool makeTargetEdges(const string& model, int n, double density, uint64_t seed, vector<pair<int, int>>& edges);
+template <typename G>
+Graph makePattern(const string& family, int size, double density, const G& target, uint64_t seed);
+bool applyOptions(const string& engine, const string& semantics, const string& symmetry,
+                  int threads, SearchOptions& options);
+bool parseOrdering(const string& name, VertexOrdering& ordering);
+bool parseOrdering(const string& name, VertexOrdering& ordering) {
+    static const map<string, VertexOrdering> orderings = {
+        {"none", VertexOrdering::None}, {"degree", VertexOrdering::DegreeDescending},
+        {"rcm", VertexOrdering::ReverseCuthillMcKee}, {"gorder", VertexOrdering::Gorder}};
+    if (!orderings.count(name)) return false;
+    ordering = orderings.at(name);
+    return true;
+}
+
+template <typename G>
+uint64_t runOnce(const G& target, const Graph& pattern, const string& mode, const SearchOptions& options,
+                 uint64_t samples);
+double percentile(const vector<double>& sorted, double q);
+string statusName(SearchStatus status);
+void writeJson(ostream& out, const vector<BenchResult>& results);
+void writeCsv(ostream& out, const vector<BenchResult>& results);
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    if (!parseArguments(argc, argv, config)) {
+        printUsage();
+        return 1;
+    }
+
+    // Загруженный граф заменяет сетку размеров и плотностей; зёрна меняют только паттерны
+    CsrGraph inputGraph;
+    Graph inputDense;
+    if (!config.input.empty()) {
+        string error;
+        if (!loadGraphFile(config.input, inputGraph, GraphLoadOptions(), &error)) {
+            cerr << "Не удалось загрузить " << config.input << ": " << error << "\n";
+            return 1;
+        }
+        if (count(config.storage.begin(), config.storage.end(), "graph")) {
+            loadGraphFile(config.input, inputDense);
+        }
+        double n = inputGraph.getVertexCount();
+        config.vertices = {inputGraph.getVertexCount()};
+        config.densities = {n > 1 ? 2.0 * inputGraph.getEdgeCount() / (n * (n - 1)) : 0.0};
+        config.models = {"file"};
+    }
+
+    vector<BenchResult> results;
+    for (int n : config.vertices)
+    for (double density : config.densities)
+    for (const string& model : config.models)
+    for (int s = 0; s < config.seeds; ++s) {
+        uint64_t seed = config.baseSeed + s;
+        Graph generated;
+        CsrGraph generatedCsr;
+        if (config.input.empty()) {
+            vector<pair<int, int>> edges;
+            if (!makeTargetEdges(model, n, density, mixSeed(seed ^ mixSeed(n)), edges)) {
+                cerr << "Неизвестная модель графа " << model << "\n";
+                return 1;
+            }
+            // Плотная матрица нужна только для хранения graph
+            if (count(config.storage.begin(), config.storage.end(), "graph")) {
+                generated = Graph(edges, n);
+            }
+            generatedCsr = CsrGraph(n, edges);
+        }
+        const Graph& target = config.input.empty() ? generated : inputDense;
+        const CsrGraph& csrTarget = config.input.empty() ? generatedCsr : inputGraph;
+
+        // Перенумерованные копии — по одной на способ. Graph ищет по своей копии и
+        // переводит сопоставления в исходные номера; CsrGraph строится заново
+        map<string, Graph> orderedTargets;
+        map<string, CsrGraph> orderedCsrTargets;
+        map<string, double> reorderMs;
+        for (const string& reorder : config.reorders) {
+            VertexOrdering ordering;
+            if (!parseOrdering(reorder, ordering)) {
+                cerr << "Неизвестная перенумерация " << reorder << "\n";
+                return 1;
+            }
+            if (ordering == VertexOrdering::None) continue;
+            auto start = chrono::steady_clock::now();
+            if (count(config.storage.begin(), config.storage.end(), "graph")) {
+                orderedTargets[reorder] = target;
+                orderedTargets[reorder].reorderVertices(ordering);
+            }
+            if (count(config.storage.begin(), config.storage.end(), "csr")) {
+                vector<int> position = inversePermutation(vertexOrder(csrTarget, ordering));
+                vector<pair<int, int>> edges;
+                edges.reserve(csrTarget.getEdgeCount());
+                for (int v = 0; v < csrTarget.getVertexCount(); ++v) {
+                    for (int w : csrTarget.getNeighbors(v)) {
+                        if (v < w) edges.push_back({position[v], position[w]});
+                    }
+                }
+                orderedCsrTargets[reorder] = CsrGraph(csrTarget.getVertexCount(), edges);
+            }
+            reorderMs[reorder] = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        }
+
+        for (int k : config.patternSizes)
+        for (const string& family : config.families) {
+            if (k > n) continue;
+            double pd = config.patternDensity < 0 ? density : config.patternDensity;
+            Graph pattern = makePattern(family, k, pd, csrTarget, mixSeed(seed + 0x9e37 * k));
+
+            for (const string& storage : config.storage)
+            for (const string& reorder : config.reorders)
+            for (const string& kernel : config.kernels)
+            for (const string& engine : config.engines)
+            for (const string& semantics : config.semantics)
+            for (const string& symmetry : config.symmetry)
+            for (int threads : config.threads)
+            for (const string& mode : config.modes) {
+                // Без плотной матрицы CsrGraph всегда ищет через VF2++
+                if (storage == "csr" && engine != "vf2pp") continue;
+
+                SearchOptions options;
+                if (!applyOptions(engine, semantics, symmetry, threads, options)) {
+                    cerr << "Неизвестный параметр поиска\n";
+                    return 1;
+                }
+                if (kernel == "general") {
+                    options.family = PatternFamily::General;
+                } else if (kernel != "auto") {
+                    cerr << "Неизвестный режим ядер " << kernel << "\n";
+                    return 1;
+                }
+
+                SearchControl control;
+                if (config.timeLimitMs > 0) {
+                    control.setTimeLimit(chrono::milliseconds(config.timeLimitMs));
+                    options.control = &control;
+                }
+
+                bool ordered = reorder != "none";
+                const Graph& runTarget = ordered ? orderedTargets[reorder] : target;
+                const CsrGraph& runCsrTarget = ordered ? orderedCsrTargets[reorder] : csrTarget;
+
+                uint64_t matches = 0;
+                vector<double> times;
+                for (int run = 0; run < config.warmup + config.repeat; ++run) {
+                    auto start = chrono::steady_clock::now();
+                    matches = storage == "csr" ? runOnce(runCsrTarget, pattern, mode, options, config.samples)
+                                               : runOnce(runTarget, pattern, mode, options, config.samples);
+                    auto end = chrono::steady_clock::now();
+                    if (run >= config.warmup) {
+                        times.push_back(chrono::duration<double, milli>(end - start).count());
+                    }
+                }
+                sort(times.begin(), times.end());
+
+                BenchResult r;
+                r.vertices = n;
+                r.edges = csrTarget.getEdgeCount();
+                r.patternSize = k;
+                r.patternEdges = pattern.getEdgeCount();
+                r.density = density;
+                r.model = model;
+                r.family = family;
+                r.engine = engine;
+                r.semantics = semantics;
+                r.symmetry = symmetry;
+                r.storage = storage;
+                r.reorder = reorder;
+                r.reorderMs = ordered ? reorderMs[reorder] : 0;
+                r.kernel = kernel;
+                r.mode = mode;
+                r.threads = threads;
+                r.seed = seed;
+                r.matches = matches;
+                r.status = statusName(control.getStatus());
+                r.runs = (int)times.size();
+                r.minMs = times.empty() ? 0 : times.front();
+                r.medianMs = percentile(times, 0.5);
+                r.p95Ms = percentile(times, 0.95);
+                r.meanMs = 0;
+                for (double t : times) r.meanMs += t;
+                r.meanMs = times.empty() ? 0 : r.meanMs / times.size();
+                results.push_back(r);
+
+                cerr << "n=" << n << " k=" << k << " p=" << density << " " << model << " " << family << " "
+                     << storage << "/" << reorder << "/" << kernel << "/" << engine << "/" << semantics << "/" << symmetry
+                     << " t=" << threads << " " << mode << " seed=" << seed
+                     << ": " << matches << ", медиана " << r.medianMs << " мс\n";
+            }
+        }
+    }
+
+    ofstream file;
+    if (!config.output.empty()) {
+        file.open(config.output);
+        if (!file.is_open()) {
+            cerr << "Не удалось открыть " << config.output << "\n";
+            return 1;
+        }
+    }
+    ostream& out = config.output.empty() ? cout : file;
+    if (config.format == "csv") {
+        writeCsv(out, results);
+    } else {
+        writeJson(out, results);
+    }
+    return 0;
+}
+
+void printUsage() {
+    cerr << "Использование: bench [--параметр=значение ...]\n"
+         << "Списки задаются через запятую, замеры идут по всем сочетаниям.\n"
+         << "  --vertices=50,100        размеры основного графа\n"
+         << "  --pattern=4,6            размеры паттерна\n"
+         << "  --density=0.1,0.3        вероятность ребра основного графа\n"
+         << "  --model=gnp,gnm,ba,regular\n"
+         << "                           модель основного графа с той же средней плотностью\n"
+         << "  --pattern-density=P      вероятность ребра случайного паттерна (по умолчанию как у графа)\n"
+         << "  --family=random,planted,clique,cycle,path,star\n"
+         << "                           planted — индуцированный подграф основного графа\n"
+         << "  --engine=backtracking,vf2pp\n"
+         << "  --semantics=induced,mono,hom\n"
+         << "  --symmetry=none,break,expand\n"
+         << "  --storage=graph,csr\n"
+         << "  --reorder=none,degree,rcm,gorder\n"
+         << "                           перенумерация вершин основного графа для локальности\n"
+         << "  --kernels=auto,general    ядра для клик, путей, циклов и звёзд или только общий движок\n"
+         << "  --mode=count,search,first,sets,estimate\n"
+         << "  --samples=1000           выборок на запуск в режиме estimate (Approximate_count.h)\n"
+         << "  --threads=1,4            0 — по числу ядер\n"
+         << "  --seeds=3 --seed=1       число графов на точку сетки и первое зерно\n"
+         << "  --warmup=1 --repeat=5    прогревочные и замеряемые запуски\n"
+         << "  --time-limit=МС          срок на один запуск; прерванные отмечаются в status\n"
+         << "  --input=файл             основной граф из файла (список рёбер, DIMACS, graph6, sparse6)\n"
+         << "  --format=json|csv --output=файл\n";
+}
+
+static vector<string> splitList(const string& value) {
+    vector<string> items;
+    stringstream ss(value);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool parseArguments(int argc, char* argv[], BenchConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+        if (arg.compare(0, 2, "--") != 0) return false;
+
+        string key, value;
+        size_t eq = arg.find('=');
+        if (eq != string::npos) {
+            key = arg.substr(2, eq - 2);
+            value = arg.substr(eq + 1);
+        } else if (i + 1 < argc) {
+            key = arg.substr(2);
+            value = argv[++i];
+        } else {
+            return false;
+        }
+
+        vector<string> items = splitList(value);
+        try {
+            if (key == "vertices" || key == "pattern" || key == "threads") {
+                vector<int>& target = key == "vertices" ? config.vertices
+                                    : key == "pattern" ? config.patternSizes : config.threads;
+                target.clear();
+                for (const string& item : items) target.push_back(stoi(item));
+            } else if (key == "density") {
+                config.densities.clear();
+                for (const string& item : items) config.densities.push_back(stod(item));
+            } else if (key == "pattern-density") {
+                config.patternDensity = stod(value);
+            } else if (key == "model") {
+                config.models = items;
+            } else if (key == "family") {
+                config.families = items;
+            } else if (key == "engine") {
+                config.engines = items;
+            } else if (key == "semantics") {
+                config.semantics = items;
+            } else if (key == "symmetry") {
+                config.symmetry = items;
+            } else if (key == "storage") {
+                config.storage = items;
+            } else if (key == "reorder") {
+                config.reorders = items;
+            } else if (key == "kernels") {
+                config.kernels = items;
+            } else if (key == "mode") {
+                config.modes = items;
+            } else if (key == "seeds") {
+                config.seeds = stoi(value);
+            } else if (key == "seed") {
+                config.baseSeed = stoull(value);
+            } else if (key == "warmup") {
+                config.warmup = stoi(value);
+            } else if (key == "repeat") {
+                config.repeat = stoi(value);
+            } else if (key == "time-limit") {
+                config.timeLimitMs = stoi(value);
+            } else if (key == "samples") {
+                config.samples = stoull(value);
+            } else if (key == "format") {
+                config.format = value;
+            } else if (key == "output") {
+                config.output = value;
+            } else if (key == "input") {
+                config.input = value;
+            } else {
+                return false;
+            }
+        } catch (const exception&) {
+            return false;
+        }
+    }
+    return config.repeat > 0 && config.warmup >= 0 && config.seeds > 0 &&
+           (config.format == "json" || config.format == "csv");
+}
+
+// Модели подбираются так, чтобы средняя степень была около density * (n - 1)
+bool makeTargetEdges(const string& model, int n, double density, uint64_t seed, vector<pair<int, int>>& edges) {
+    double degree = density * (n - 1);
+    if (model == "gnp") {
+        edges = randomGnp(n, density, seed);
+    } else if (model == "gnm") {
+        edges = randomGnm(n, llround(degree * n / 2), seed);
+    } else if (model == "ba") {
+        edges = randomBarabasiAlbert(n, max(1, (int)lround(degree / 2)), seed);
+    } else if (model == "regular") {
+        int d = (int)lround(degree);
+        if ((int64_t)n * d % 2 != 0) --d;
+        edges = randomRegular(n, d, seed);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+template <typename G>
+Graph makePattern(const string& family, int size, double density, const G& target, uint64_t seed) {
+    Graph pattern(size);
+    if (family == "clique") {
+        for (int i = 0; i < size; ++i)
+            for (int j = i + 1; j < size; ++j) pattern.addEdge(i, j);
+    } else if (family == "cycle") {
+        for (int i = 0; i < size; ++i) pattern.addEdge(i, (i + 1) % size);
+    } else if (family == "path") {
+        for (int i = 0; i + 1 < size; ++i) pattern.addEdge(i, i + 1);
+    } else if (family == "star") {
+        for (int i = 1; i < size; ++i) pattern.addEdge(0, i);
+    } else if (family == "planted") {
+        // Случайные вершины основного графа: хотя бы одно вхождение гарантировано
+        vector<int> vertices(target.getVertexCount());
+        for (int v = 0; v < (int)vertices.size(); ++v) vertices[v] = v;
+        mt19937_64 gen(seed);
+        shuffle(vertices.begin(), vertices.end(), gen);
+        for (int i = 0; i < size; ++i)
+            for (int j = i + 1; j < size; ++j)
+                if (target.hasEdge(vertices[i], vertices[j])) pattern.addEdge(i, j);
+    } else {
+        pattern.generateRandom(size, density, seed);
+    }
+    return pattern;
+}
+
+bool applyOptions(const string& engine, const string& semantics, const string& symmetry,
+                  int threads, SearchOptions& options) {
+    static const map<string, MatchEngine> engines = {
+        {"backtracking", MatchEngine::Backtracking}, {"vf2pp", MatchEngine::VF2pp}};
+    static const map<string, MatchSemantics> semanticsModes = {
+        {"induced", MatchSemantics::Induced}, {"mono", MatchSemantics::Monomorphism},
+        {"hom", MatchSemantics::Homomorphism}};
+    static const map<string, SymmetryMode> symmetryModes = {
+        {"none", SymmetryMode::None}, {"break", SymmetryMode::Break}, {"expand", SymmetryMode::Expand}};
+
+    if (!engines.count(engine) || !semanticsModes.count(semantics) || !symmetryModes.count(symmetry)) {
+        return false;
+    }
+    options.engine = engines.at(engine);
+    options.semantics = semanticsModes.at(semantics);
+    options.symmetry = symmetryModes.at(symmetry);
+    options.threads = threads;
+    return true;
+}
+
+template <typename G>
+uint64_t runOnce(const G& target, const Graph& pattern, const string& mode, const SearchOptions& options,
+                 uint64_t samples) {
+    if (mode == "search") {
+        return target.findIsomorphicSubgraph(pattern, options).size();
+    }
+    if (mode == "first") {
+        vector<int> mapping;
+        return target.findFirst(pattern, mapping, options) ? 1 : 0;
+    }
+    if (mode == "sets") {
+        return target.countIsomorphicSubgraphs(pattern, options, true).vertexSets;
+    }
+    if (mode == "estimate") {
+        // Фиксированное число выборок, чтобы время было сравнимо между сборками
+        EstimateOptions estimate;
+        estimate.semantics = options.semantics;
+        estimate.threads = options.threads;
+        estimate.maxSamples = samples;
+        estimate.timeLimit = chrono::steady_clock::duration::zero();
+        return (uint64_t)llround(estimateMatches(target, pattern, estimate).mappings);
+    }
+    return target.countIsomorphicSubgraphs(pattern, options).mappings;
+}
+
+string statusName(SearchStatus status) {
+    switch (status) {
+        case SearchStatus::TimedOut: return "timed_out";
+        case SearchStatus::BudgetExhausted: return "budget_exhausted";
+        case SearchStatus::Cancelled: return "cancelled";
+        default: return "completed";
+    }
+}
+
+// Ближайший ранг: наименьшее значение, не меньше которого доля q замеров
+double percentile(const vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)ceil(q * sorted.size());
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+void writeJson(ostream& out, const vector<BenchResult>& results) {
+    out << fixed << setprecision(4);
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "  {\"vertices\": " << r.vertices << ", \"edges\": " << r.edges
+            << ", \"pattern\": " << r.patternSize << ", \"pattern_edges\": " << r.patternEdges
+            << ", \"density\": " << r.density << ", \"model\": \"" << r.model << "\""
+            << ", \"family\": \"" << r.family << "\""
+            << ", \"storage\": \"" << r.storage << "\", \"reorder\": \"" << r.reorder << "\""
+            << ", \"reorder_ms\": " << r.reorderMs << ", \"kernel\": \"" << r.kernel << "\""
+            << ", \"engine\": \"" << r.engine << "\""
+            << ", \"semantics\": \"" << r.semantics << "\", \"symmetry\": \"" << r.symmetry << "\""
+            << ", \"mode\": \"" << r.mode << "\", \"threads\": " << r.threads
+            << ", \"seed\": " << r.seed << ", \"matches\": " << r.matches
+            << ", \"status\": \"" << r.status << "\", \"runs\": " << r.runs
+            << ", \"min_ms\": " << r.minMs << ", \"median_ms\": " << r.medianMs
+            << ", \"p95_ms\": " << r.p95Ms << ", \"mean_ms\": " << r.meanMs << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+void writeCsv(ostream& out, const vector<BenchResult>& results) {
+    out << fixed << setprecision(4);
+    out << "vertices,edges,pattern,pattern_edges,density,model,family,storage,reorder,reorder_ms,kernel,engine,semantics,symmetry,"
+        << "mode,threads,seed,matches,status,runs,min_ms,median_ms,p95_ms,mean_ms\n";
+    for (const BenchResult& r : results) {
+        out << r.vertices << "," << r.edges << "," << r.patternSize << "," << r.patternEdges << ","
+            << r.density << "," << r.model << "," << r.family << "," << r.storage << "," << r.reorder << ","
+            << r.reorderMs << "," << r.kernel << "," << r.engine << ","
+            << r.semantics << "," << r.symmetry << "," << r.mode << "," << r.threads << ","
+            << r.seed << "," << r.matches << "," << r.status << "," << r.runs << "," << r.minMs << ","
+            << r.medianMs << "," << r.p95Ms << "," << r.meanMs << "\n";
+    }
+}
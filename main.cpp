@@ -14,6 +14,10 @@ void randomTests();
 
 void timeMeasurement();
 
+#ifdef SUBGRAPH_SEARCH_STATS
+void printSearchStats(const SearchStats& stats);
+#endif
+
 int main() {
     setlocale(LC_ALL, "Ru");
     
@@ -124,8 +128,13 @@ void manualInput() {
     pattern.printInfo();
     
     cout << "\n ПОИСК ИЗОМОРФНОГО ПОДГРАФА \n";
+    SearchOptions options;
+#ifdef SUBGRAPH_SEARCH_STATS
+    SearchStats stats;
+    options.stats = &stats;
+#endif
     auto start = chrono::high_resolution_clock::now();
-    auto mappings = mainGraph.findIsomorphicSubgraph(pattern);
+    auto mappings = mainGraph.findIsomorphicSubgraph(pattern, options);
     auto end = chrono::high_resolution_clock::now();
     
     chrono::duration<double> duration = end - start;
@@ -133,6 +142,9 @@ void manualInput() {
     cout << "Время поиска: " << fixed << setprecision(6) 
          << duration.count() << " секунд\n";
     cout << "Найдено " << mappings.size() << " изоморфных подграфов\n\n";
+#ifdef SUBGRAPH_SEARCH_STATS
+    printSearchStats(stats);
+#endif
     
     if (!mappings.empty()) {
         cout << "Сопоставления вершин (паттерн -> граф):\n";
@@ -224,8 +236,9 @@ void randomTests() {
         
         GraphVisualizer::saveComparisonToSVG(mainGraph, pattern, mappings[0], 
                                            "random_comparison.svg");
+        GraphVisualizer::saveMatchesToSVG(mainGraph, pattern, mappings, "random_matches.svg");
         
-        cout << "\nРезультат сохранён в random_comparison.svg\n";
+        cout << "\nРезультат сохранён в random_comparison.svg, все сопоставления — в random_matches.svg\n";
         cout << "Откройте файл в браузере для просмотра.\n";
     } else {
         cout << "Изоморфный подграф не найден.\n";
@@ -275,7 +288,7 @@ void timeMeasurement() {
         pattern.generateRandom(patternSize, probability);
         
         auto start = chrono::high_resolution_clock::now();
-        auto mappings = mainGraph.findIsomorphicSubgraph(pattern);
+        MatchCount found = mainGraph.countIsomorphicSubgraphs(pattern);
         auto end = chrono::high_resolution_clock::now();
         
         chrono::duration<double> duration = end - start;
@@ -283,11 +296,32 @@ void timeMeasurement() {
         cout << setw(15) << graphSize
              << setw(15) << patternSize
              << setw(20) << fixed << setprecision(6) << duration.count()
-             << setw(15) << mappings.size()
+             << setw(15) << found.mappings
              << "\n";
     }
     
     cout << "\nНажмите Enter для продолжения...";
     cin.ignore();
     cin.get();
-}
\ No newline at end of file
+}
+
+#ifdef SUBGRAPH_SEARCH_STATS
+void printSearchStats(const SearchStats& stats) {
+    cout << "Статистика поиска:\n";
+    cout << "  Узлов по уровням:";
+    for (uint64_t nodes : stats.nodesPerDepth) cout << " " << nodes;
+    cout << "\n";
+    cout << "  Кандидатов проверено: " << stats.candidatesTried
+         << ", найдено: " << stats.matches << ", наибольшая глубина: " << stats.maxDepth << "\n";
+    cout << "  Отсев доменов: метки " << stats.domainLabel << ", степень " << stats.domainDegree
+         << ", степени соседей " << stats.domainNeighborDegrees << ", треугольники " << stats.domainTriangles
+         << ", согласованность по дугам " << stats.domainArcConsistency << "\n";
+    cout << "  Отсев при переборе: домен " << stats.prunedDomain << ", занятость " << stats.prunedInjectivity
+         << ", симметрия " << stats.prunedSymmetry << ", степень " << stats.prunedDegree
+         << ", смежность " << stats.prunedAdjacency << ", метки рёбер " << stats.prunedEdgeLabel
+         << ", терминальные множества " << stats.prunedLookahead
+         << ", проверка вперёд " << stats.prunedForwardCheck << "\n";
+    cout << "  Время, с: подготовка " << stats.preprocessSeconds << ", обход " << stats.searchSeconds
+         << ", выдача " << stats.outputSeconds << "\n\n";
+}
+#endif
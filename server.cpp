@@ -0,0 +1,623 @@
+// Резидентный сервер поиска подграфов: основной граф загружается и индексируется один раз,
+// запросы приходят через Unix-сокет и выполняются параллельно на пуле потоков.
+// Только POSIX. Сборка: g++ -std=c++17 -O2 -pthread server.cpp -o server
+// Пример:  ./server --input=graph.txt --socket=/tmp/subgraph.sock --workers=4 --deadline=2000
+//          echo "search q1 3:0-1,1-2,2-0 limit=10" | ./server --client --socket=/tmp/subgraph.sock
+//
+// Протокол — строки, поля через пробел. Запросы:
+//   search ID ПАТТЕРН [параметры]   сопоставления по мере нахождения: "match ID v0 v1 ...",
+//                                    в конце "done ID СТАТУС ЧИСЛО МС"
+//   count ID ПАТТЕРН [параметры]    только "done ID СТАТУС ЧИСЛО МС"
+//   cancel ID                        запрос завершится со статусом cancelled
+//   info                             "info vertices=N edges=M workers=W"
+//   ping                             "pong"
+//   quit                             отменить запросы соединения и закрыть его
+// ПАТТЕРН — "K:u-v,u-v,..." (K вершин, рёбра с номерами от 0), метка ребра — "u-v:L".
+// Параметры: semantics=induced|mono|hom, symmetry=none|break|expand, engine=backtracking|vf2pp,
+// labels=L0,L1,... (метки вершин паттерна), deadline=МС (от получения запроса, 0 — без срока),
+// budget=УЗЛЫ, limit=N (не больше N сопоставлений), threads=T (потоков на один запрос).
+// СТАТУС — completed, limit, timed_out, budget_exhausted или cancelled.
+// Ошибка разбора — "error ID сообщение". Строки разных запросов одного соединения
+// перемежаются, но каждая строка приходит целиком. ID выбирает клиент; он должен быть
+// уникален среди незавершённых запросов соединения. После конца ввода от клиента
+// начатые запросы доводятся до конца, если клиент ещё читает ответы
+#include "Csr_graph.h"
+#include "Graph_io.h"
+#include "Thread_pool.h"
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+struct ServerConfig {
+    string input;                   // список рёбер, DIMACS, graph6, sparse6
+    string snapshot;                // двоичный снимок (saveGraphSnapshot)
+    bool verifySnapshot = true;     // проверка суммы данных снимка: без неё повреждённый файл опасен
+    int randomVertices = 0;         // без файла — G(n, p) с зерном
+    double randomDensity = 0.01;
+    uint64_t seed = 1;
+    bool matrix = false;            // матрица смежности: без неё поиск идёт через VF2++
+    string socketPath = "/tmp/subgraph_search.sock";
+    int workers = 0;                // 0 — по числу ядер
+    int deadlineMs = 0;             // срок по умолчанию; 0 — без срока
+    bool client = false;
+};
+
+// Запрос в работе; control доступен для cancel из потока чтения
+struct ActiveQuery {
+    string id;
+    SearchControl control;
+};
+
+// Соединение живёт, пока его держат поток чтения или незавершённые запросы
+class Connection {
+private:
+    int fd;
+    mutex writeLock;
+    bool broken;
+    mutex queriesLock;
+    map<string, shared_ptr<ActiveQuery>> queries;
+
+public:
+    explicit Connection(int socket) : fd(socket), broken(false) {}
+    ~Connection() { close(fd); }
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    int socket() const { return fd; }
+    // Пишет целые строки; false — клиент отключился
+    bool send(const string& text);
+    shared_ptr<ActiveQuery> start(const string& id);
+    void finish(const string& id);
+    bool cancel(const string& id);
+    void cancelAll();
+};
+
+struct QueryRequest {
+    string id;
+    bool stream = true;
+    Graph pattern;
+    SearchOptions options;
+    uint64_t limit = 0;             // 0 — без ограничения
+    chrono::steady_clock::time_point received;
+    int deadlineMs = 0;
+    uint64_t budget = 0;
+};
+
+void printUsage();
+bool parseArguments(int argc, char* argv[], ServerConfig& config);
+bool loadTarget(const ServerConfig& config, CsrGraph& target);
+bool parsePattern(const string& text, Graph& pattern, string& error);
+bool parseQuery(const vector<string>& fields, const ServerConfig& config, QueryRequest& request, string& error);
+void runQuery(const CsrGraph& target, const TargetIndex& index, Connection& connection,
+              ActiveQuery& query, QueryRequest& request);
+void serveConnection(shared_ptr<Connection> connection, const CsrGraph& target, const TargetIndex& index,
+                     WorkStealingPool& pool, const ServerConfig& config);
+int runServer(const ServerConfig& config);
+int runClient(const ServerConfig& config);
+string statusName(SearchStatus status);
+
+static atomic<bool> stopRequested(false);
+
+static void onSignal(int) {
+    stopRequested = true;
+}
+
+int main(int argc, char* argv[]) {
+    ServerConfig config;
+    if (!parseArguments(argc, argv, config)) {
+        printUsage();
+        return 1;
+    }
+    return config.client ? runClient(config) : runServer(config);
+}
+
+void printUsage() {
+    cerr << "Использование: server [--параметр=значение ...]\n"
+         << "  --input=файл             основной граф (список рёбер, DIMACS, graph6, sparse6)\n"
+         << "  --snapshot=файл          основной граф из двоичного снимка\n"
+         << "  --verify-snapshot=0|1    проверять сумму данных снимка (по умолчанию 1)\n"
+         << "  --random=N,P             без файла: G(N, P), зерно --seed=1\n"
+         << "  --matrix                 построить матрицу смежности (backtracking вместо VF2++)\n"
+         << "  --socket=путь            по умолчанию /tmp/subgraph_search.sock\n"
+         << "  --workers=N              запросов одновременно; 0 — по числу ядер\n"
+         << "  --deadline=МС            срок запроса по умолчанию; 0 — без срока\n"
+         << "  --client                 клиент: строки запросов со стандартного ввода, ответы на вывод\n";
+}
+
+static vector<string> splitBy(const string& value, char separator) {
+    vector<string> items;
+    stringstream ss(value);
+    string item;
+    while (getline(ss, item, separator)) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+bool parseArguments(int argc, char* argv[], ServerConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+        if (arg == "--client") {
+            config.client = true;
+            continue;
+        }
+        if (arg == "--matrix") {
+            config.matrix = true;
+            continue;
+        }
+        if (arg.compare(0, 2, "--") != 0) return false;
+
+        string key, value;
+        size_t eq = arg.find('=');
+        if (eq != string::npos) {
+            key = arg.substr(2, eq - 2);
+            value = arg.substr(eq + 1);
+        } else if (i + 1 < argc) {
+            key = arg.substr(2);
+            value = argv[++i];
+        } else {
+            return false;
+        }
+
+        try {
+            if (key == "input") {
+                config.input = value;
+            } else if (key == "snapshot") {
+                config.snapshot = value;
+            } else if (key == "verify-snapshot") {
+                if (value != "0" && value != "1") return false;
+                config.verifySnapshot = value == "1";
+            } else if (key == "random") {
+                vector<string> items = splitBy(value, ',');
+                if (items.size() != 2) return false;
+                config.randomVertices = stoi(items[0]);
+                config.randomDensity = stod(items[1]);
+            } else if (key == "seed") {
+                config.seed = stoull(value);
+            } else if (key == "socket") {
+                config.socketPath = value;
+            } else if (key == "workers") {
+                config.workers = stoi(value);
+            } else if (key == "deadline") {
+                config.deadlineMs = stoi(value);
+            } else {
+                return false;
+            }
+        } catch (const exception&) {
+            return false;
+        }
+    }
+    return config.client || !config.input.empty() || !config.snapshot.empty() || config.randomVertices > 0;
+}
+
+bool loadTarget(const ServerConfig& config, CsrGraph& target) {
+    string error;
+    if (!config.snapshot.empty()) {
+        if (!loadGraphSnapshot(config.snapshot, target, config.verifySnapshot, &error)) {
+            cerr << "Не удалось загрузить " << config.snapshot << ": " << error << "\n";
+            return false;
+        }
+    } else if (!config.input.empty()) {
+        if (!loadGraphFile(config.input, target, GraphLoadOptions(), &error)) {
+            cerr << "Не удалось загрузить " << config.input << ": " << error << "\n";
+            return false;
+        }
+    } else {
+        target = CsrGraph(config.randomVertices, randomGnp(config.randomVertices, config.randomDensity, config.seed));
+    }
+    if (config.matrix) target.buildAdjMatrix();
+    return true;
+}
+
+// "K:u-v,u-v:L,..."
+bool parsePattern(const string& text, Graph& pattern, string& error) {
+    size_t colon = text.find(':');
+    if (colon == string::npos) {
+        error = "паттерн задаётся как K:u-v,...";
+        return false;
+    }
+    try {
+        int k = stoi(text.substr(0, colon));
+        if (k < 1 || k > 64) {
+            error = "число вершин паттерна должно быть от 1 до 64";
+            return false;
+        }
+        pattern = Graph(k);
+        for (const string& item : splitBy(text.substr(colon + 1), ',')) {
+            size_t dash = item.find('-');
+            size_t label = item.find(':');
+            if (dash == string::npos) {
+                error = "ребро " + item + " задаётся как u-v";
+                return false;
+            }
+            int u = stoi(item.substr(0, dash));
+            int v = stoi(item.substr(dash + 1, label == string::npos ? string::npos : label - dash - 1));
+            if (u < 0 || u >= k || v < 0 || v >= k || u == v) {
+                error = "недопустимое ребро " + item;
+                return false;
+            }
+            pattern.addEdge(u, v);
+            if (label != string::npos) pattern.setEdgeLabel(u, v, stoi(item.substr(label + 1)));
+        }
+    } catch (const exception&) {
+        error = "не удалось разобрать паттерн " + text;
+        return false;
+    }
+    return true;
+}
+
+bool parseQuery(const vector<string>& fields, const ServerConfig& config, QueryRequest& request, string& error) {
+    static const map<string, MatchEngine> engines = {
+        {"backtracking", MatchEngine::Backtracking}, {"vf2pp", MatchEngine::VF2pp}};
+    static const map<string, MatchSemantics> semanticsModes = {
+        {"induced", MatchSemantics::Induced}, {"mono", MatchSemantics::Monomorphism},
+        {"hom", MatchSemantics::Homomorphism}};
+    static const map<string, SymmetryMode> symmetryModes = {
+        {"none", SymmetryMode::None}, {"break", SymmetryMode::Break}, {"expand", SymmetryMode::Expand}};
+
+    request.received = chrono::steady_clock::now();
+    request.stream = fields[0] == "search";
+    request.deadlineMs = config.deadlineMs;
+    if (fields.size() < 3) {
+        error = "нужны ID и паттерн";
+        return false;
+    }
+    request.id = fields[1];
+    if (!parsePattern(fields[2], request.pattern, error)) return false;
+
+    for (size_t i = 3; i < fields.size(); ++i) {
+        size_t eq = fields[i].find('=');
+        string key = fields[i].substr(0, eq);
+        string value = eq == string::npos ? "" : fields[i].substr(eq + 1);
+        try {
+            if (key == "semantics" && semanticsModes.count(value)) {
+                request.options.semantics = semanticsModes.at(value);
+            } else if (key == "symmetry" && symmetryModes.count(value)) {
+                request.options.symmetry = symmetryModes.at(value);
+            } else if (key == "engine" && engines.count(value)) {
+                request.options.engine = engines.at(value);
+            } else if (key == "labels") {
+                vector<string> labels = splitBy(value, ',');
+                if ((int)labels.size() != request.pattern.getVertexCount()) {
+                    error = "меток вершин должно быть столько же, сколько вершин паттерна";
+                    return false;
+                }
+                for (size_t v = 0; v < labels.size(); ++v) request.pattern.setVertexLabel((int)v, stoi(labels[v]));
+            } else if (key == "deadline") {
+                request.deadlineMs = stoi(value);
+            } else if (key == "budget") {
+                request.budget = stoull(value);
+            } else if (key == "limit") {
+                request.limit = stoull(value);
+            } else if (key == "threads") {
+                request.options.threads = max(1, stoi(value));
+            } else {
+                error = "неизвестный параметр " + fields[i];
+                return false;
+            }
+        } catch (const exception&) {
+            error = "не удалось разобрать " + fields[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+string statusName(SearchStatus status) {
+    switch (status) {
+        case SearchStatus::TimedOut: return "timed_out";
+        case SearchStatus::BudgetExhausted: return "budget_exhausted";
+        case SearchStatus::Cancelled: return "cancelled";
+        default: return "completed";
+    }
+}
+
+inline bool Connection::send(const string& text) {
+    lock_guard<mutex> guard(writeLock);
+    size_t sent = 0;
+    while (!broken && sent < text.size()) {
+        ssize_t written = ::send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) broken = true;
+        else sent += written;
+    }
+    return !broken;
+}
+
+inline shared_ptr<ActiveQuery> Connection::start(const string& id) {
+    lock_guard<mutex> guard(queriesLock);
+    if (queries.count(id)) return nullptr;
+    auto query = make_shared<ActiveQuery>();
+    query->id = id;
+    queries[id] = query;
+    return query;
+}
+
+inline void Connection::finish(const string& id) {
+    lock_guard<mutex> guard(queriesLock);
+    queries.erase(id);
+}
+
+inline bool Connection::cancel(const string& id) {
+    lock_guard<mutex> guard(queriesLock);
+    auto it = queries.find(id);
+    if (it == queries.end()) return false;
+    it->second->control.cancel();
+    return true;
+}
+
+inline void Connection::cancelAll() {
+    lock_guard<mutex> guard(queriesLock);
+    for (auto& query : queries) query.second->control.cancel();
+}
+
+// Сопоставления копятся в буфере и уходят, когда он заполнится или с прошлой отправки
+// прошло больше 20 мс, так что первые результаты не ждут конца поиска
+void runQuery(const CsrGraph& target, const TargetIndex& index, Connection& connection,
+              ActiveQuery& query, QueryRequest& request) {
+    auto started = chrono::steady_clock::now();
+    SearchOptions options = request.options;
+    options.targetIndex = &index;
+    options.control = &query.control;
+    if (request.deadlineMs > 0) {
+        query.control.setDeadline(request.received + chrono::milliseconds(request.deadlineMs));
+    }
+    query.control.setNodeBudget(request.budget);
+
+    uint64_t found = 0;
+    bool limited = false;
+    string buffer;
+    auto flushed = started;
+    if (request.stream) {
+        MatchVisitor visitor = [&](const vector<int>& mapping) {
+            found++;
+            buffer += "match " + query.id;
+            for (int v : mapping) {
+                buffer += ' ';
+                buffer += to_string(v);
+            }
+            buffer += '\n';
+            auto now = chrono::steady_clock::now();
+            if (buffer.size() >= 16384 || now - flushed >= chrono::milliseconds(20)) {
+                if (!connection.send(buffer)) return false;
+                buffer.clear();
+                flushed = now;
+            }
+            if (request.limit != 0 && found >= request.limit) {
+                limited = true;
+                return false;
+            }
+            return true;
+        };
+        target.findIsomorphicSubgraph(request.pattern, visitor, options);
+    } else {
+        found = target.countIsomorphicSubgraphs(request.pattern, options).mappings;
+    }
+
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+    ostringstream done;
+    done << "done " << query.id << ' ' << (limited ? "limit" : statusName(query.control.getStatus()))
+         << ' ' << found << ' ' << fixed << setprecision(3) << ms << '\n';
+    buffer += done.str();
+    // Сначала освобождается ID: клиент, получивший done, может сразу его переиспользовать
+    connection.finish(query.id);
+    connection.send(buffer);
+}
+
+// Поток чтения соединения: разбирает строки и отправляет запросы в пул. Соединение
+// закрывается, когда закончится чтение и все его запросы
+void serveConnection(shared_ptr<Connection> connection, const CsrGraph& target, const TargetIndex& index,
+                     WorkStealingPool& pool, const ServerConfig& config) {
+    string pending;
+    char chunk[65536];
+    bool open = true;
+    bool quit = false;
+    while (open) {
+        ssize_t got = recv(connection->socket(), chunk, sizeof(chunk), 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        pending.append(chunk, got);
+        size_t start = 0, newline;
+        while (open && (newline = pending.find('\n', start)) != string::npos) {
+            string line = pending.substr(start, newline - start);
+            start = newline + 1;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            vector<string> fields = splitBy(line, ' ');
+            if (fields.empty()) continue;
+            const string& command = fields[0];
+            if (command == "search" || command == "count") {
+                auto request = make_shared<QueryRequest>();
+                string error;
+                string id = fields.size() > 1 ? fields[1] : "-";
+                shared_ptr<ActiveQuery> query;
+                if (stopRequested) {
+                    connection->send("error " + id + " сервер останавливается\n");
+                } else if (!parseQuery(fields, config, *request, error)) {
+                    connection->send("error " + id + ' ' + error + '\n');
+                } else if (!(query = connection->start(request->id))) {
+                    connection->send("error " + id + " запрос с таким ID ещё выполняется\n");
+                } else {
+                    pool.submit([connection, query, request, &target, &index](int) {
+                        runQuery(target, index, *connection, *query, *request);
+                    });
+                }
+            } else if (command == "cancel" && fields.size() == 2) {
+                if (!connection->cancel(fields[1])) connection->send("error " + fields[1] + " нет такого запроса\n");
+            } else if (command == "info") {
+                connection->send("info vertices=" + to_string(target.getVertexCount()) + " edges=" +
+                                 to_string(target.getEdgeCount()) + " workers=" + to_string(pool.size()) + '\n');
+            } else if (command == "ping") {
+                connection->send("pong\n");
+            } else if (command == "quit") {
+                open = false;
+                quit = true;
+            } else {
+                connection->send("error - неизвестная команда " + command + '\n');
+            }
+        }
+        pending.erase(0, start);
+        if (pending.size() > (1 << 24)) {
+            connection->send("error - слишком длинная строка\n");
+            break;
+        }
+    }
+    if (quit) {
+        connection->cancelAll();
+        shutdown(connection->socket(), SHUT_RDWR);
+    }
+}
+
+int runServer(const ServerConfig& config) {
+    CsrGraph target;
+    auto loading = chrono::steady_clock::now();
+    if (!loadTarget(config, target)) return 1;
+    TargetIndex index = buildTargetIndex(target);
+    cerr << "Граф: " << target.getVertexCount() << " вершин, " << target.getEdgeCount() << " рёбер, загружен за "
+         << chrono::duration<double>(chrono::steady_clock::now() - loading).count() << " с\n";
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (listener < 0 || config.socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Не удалось создать сокет " << config.socketPath << "\n";
+        return 1;
+    }
+    strncpy(address.sun_path, config.socketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(config.socketPath.c_str());
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        cerr << "Не удалось открыть " << config.socketPath << ": " << strerror(errno) << "\n";
+        close(listener);
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    WorkStealingPool pool(config.workers > 0 ? config.workers : (int)max(1u, thread::hardware_concurrency()));
+    cerr << "Ожидание запросов на " << config.socketPath << ", исполнителей: " << pool.size() << "\n";
+
+    struct Reader {
+        thread worker;
+        shared_ptr<atomic<bool>> finished;
+        weak_ptr<Connection> connection;
+    };
+    vector<Reader> readers;
+    while (!stopRequested) {
+        // Завершившиеся потоки чтения убираются; флаг остановки проверяется не реже раза в 200 мс
+        for (size_t i = 0; i < readers.size();) {
+            if (*readers[i].finished) {
+                readers[i].worker.join();
+                readers[i] = move(readers.back());
+                readers.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        pollfd waiting = {listener, POLLIN, 0};
+        if (poll(&waiting, 1, 200) <= 0) continue;
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+        auto connection = make_shared<Connection>(client);
+        auto finished = make_shared<atomic<bool>>(false);
+        thread worker([connection, finished, &target, &index, &pool, &config]() {
+            serveConnection(connection, target, index, pool, config);
+            *finished = true;
+        });
+        readers.push_back({move(worker), finished, connection});
+    }
+
+    cerr << "Остановка\n";
+    close(listener);
+    unlink(config.socketPath.c_str());
+    // Запросы отменяются, но успевают отправить done; чтение прекращается сразу
+    for (Reader& reader : readers) {
+        if (auto connection = reader.connection.lock()) {
+            connection->cancelAll();
+            shutdown(connection->socket(), SHUT_RD);
+        }
+    }
+    for (Reader& reader : readers) reader.worker.join();
+    pool.wait();
+    return 0;
+}
+
+// Отправляет стандартный ввод и печатает ответы, пока сервер не закроет соединение
+// или не придут done/error на все отправленные search и count и ответы на info и ping
+int runClient(const ServerConfig& config) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, config.socketPath.c_str(), sizeof(address.sun_path) - 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        cerr << "Не удалось подключиться к " << config.socketPath << "\n";
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    mutex awaitedLock;
+    multiset<string> awaitedIds;
+    int awaitedReplies = 0;         // info и ping
+    atomic<bool> inputDone(false);
+    auto idle = [&]() {
+        lock_guard<mutex> guard(awaitedLock);
+        return awaitedIds.empty() && awaitedReplies == 0;
+    };
+    thread writer([&]() {
+        string line;
+        while (getline(cin, line)) {
+            vector<string> fields = splitBy(line, ' ');
+            if (fields.empty()) continue;
+            {
+                lock_guard<mutex> guard(awaitedLock);
+                if ((fields[0] == "search" || fields[0] == "count") && fields.size() > 1) awaitedIds.insert(fields[1]);
+                if (fields[0] == "info" || fields[0] == "ping") awaitedReplies++;
+            }
+            line += '\n';
+            if (::send(fd, line.data(), line.size(), MSG_NOSIGNAL) != (ssize_t)line.size()) break;
+        }
+        inputDone = true;
+    });
+
+    string pending;
+    char chunk[65536];
+    while (true) {
+        if (inputDone && idle()) break;
+        pollfd waiting = {fd, POLLIN, 0};
+        if (poll(&waiting, 1, 50) <= 0) continue;
+        ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+        if (got <= 0) break;
+        pending.append(chunk, got);
+        size_t start = 0, newline;
+        while ((newline = pending.find('\n', start)) != string::npos) {
+            string line = pending.substr(start, newline - start);
+            start = newline + 1;
+            cout << line << '\n';
+            vector<string> fields = splitBy(line, ' ');
+            lock_guard<mutex> guard(awaitedLock);
+            if ((fields[0] == "done" || fields[0] == "error") && fields.size() > 1 && awaitedIds.count(fields[1])) {
+                awaitedIds.erase(awaitedIds.find(fields[1]));
+            } else if (fields[0] == "info" || fields[0] == "pong") {
+                awaitedReplies--;
+            }
+        }
+        pending.erase(0, start);
+    }
+    cout.flush();
+    shutdown(fd, SHUT_RDWR);
+    writer.join();
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Регрессионные проверки. Сборка: g++ -std=c++17 -O2 -pthread tests.cpp -o tests
+// Запуск: ./tests — печатает непрошедшие проверки, код возврата 1 при ошибках
+#include "Graph.h"
+#include "Batch_search.h"
+#include "Continuous_query.h"
+#include "Graph_io.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const string& what) {
+    if (!condition) {
+        failures++;
+        cout << "FAIL: " << what << endl;
+    }
+}
+
+// Непрерывный запрос по перенумерованному графу с Break: обработчик не должен удалять
+// сопоставления, которых не добавлял, а итог — совпадать с новым поиском
+void testContinuousQueryReordered() {
+    Graph triangle({{0, 1}, {1, 2}, {2, 0}}, 3);
+    SearchOptions options;
+    options.symmetry = SymmetryMode::Break;
+    for (uint64_t seed = 1; seed <= 200; ++seed) {
+        Graph graph;
+        graph.generateRandom(12, 1.0 / 3, seed);
+        graph.reorderVertices(VertexOrdering::DegreeDescending);
+
+        set<vector<int>> live;
+        bool consistent = true;
+        ContinuousQuery query(graph, triangle, [&](const vector<int>& mapping, bool added) {
+            if (added) {
+                consistent = live.insert(mapping).second && consistent;
+            } else {
+                consistent = live.erase(mapping) == 1 && consistent;
+            }
+        }, options);
+
+        mt19937_64 random(seed);
+        for (int step = 0; step < 40; ++step) {
+            int u = (int)(random() % 12), v = (int)(random() % 12);
+            if (u == v) continue;
+            if (graph.hasEdge(u, v)) {
+                graph.removeEdge(u, v);
+            } else {
+                graph.addEdge(u, v);
+            }
+        }
+
+        // Копия без перенумерации выбирает представителей в исходных номерах
+        Graph plain = graph;
+        plain.reorderVertices(VertexOrdering::None);
+        vector<vector<int>> truth = plain.findIsomorphicSubgraph(triangle, options);
+        string where = " (seed " + to_string(seed) + ")";
+        check(consistent, "ContinuousQuery: удалено не добавленное сопоставление" + where);
+        check(live == set<vector<int>>(truth.begin(), truth.end()),
+              "ContinuousQuery: итог не совпадает с новым поиском" + where);
+        check(query.getMatchCount() == truth.size(), "ContinuousQuery: getMatchCount" + where);
+        check(graph.countIsomorphicSubgraphs(triangle, options).mappings == truth.size(),
+              "перенумерованный граф: число сопоставлений при Break" + where);
+    }
+}
+
+// Индекс графа и BatchQuery, построенные до добавления рёбер, не должны занижать ответ
+void testStaleTargetIndex() {
+    Graph diamond({{0, 1}, {1, 2}, {2, 0}, {1, 3}, {2, 3}}, 4);
+    for (uint64_t seed = 1; seed <= 50; ++seed) {
+        Graph graph;
+        graph.generateRandom(30, 0.15, seed);
+        TargetIndex index = buildTargetIndex(graph);
+        BatchQuery<Graph> batch(graph);
+
+        mt19937_64 random(seed);
+        for (int added = 0; added < 40;) {
+            int u = (int)(random() % 30), v = (int)(random() % 30);
+            if (u == v || graph.hasEdge(u, v)) continue;
+            graph.addEdge(u, v);
+            added++;
+        }
+
+        uint64_t truth = graph.countIsomorphicSubgraphs(diamond).mappings;
+        SearchOptions options;
+        options.targetIndex = &index;
+        string where = " (seed " + to_string(seed) + ")";
+        check(graph.countIsomorphicSubgraphs(diamond, options).mappings == truth,
+              "устаревший TargetIndex: неверное число сопоставлений" + where);
+        check(batch.count(vector<Graph>{diamond})[0] == truth,
+              "BatchQuery после изменения графа: неверное число сопоставлений" + where);
+    }
+}
+
+// Записывает содержимое во временный файл с нужным расширением и загружает его
+static bool loadText(const string& extension, const string& content, Graph& graph, string& error) {
+    string filename = "tests_loader." + extension;
+    {
+        ofstream out(filename, ios::binary | ios::trunc);
+        out << content;
+    }
+    error.clear();
+    bool loaded = loadGraphFile(filename, graph, GraphLoadOptions(), &error);
+    remove(filename.c_str());
+    return loaded;
+}
+
+// Пустые, обрезанные и повреждённые файлы graph6/sparse6 отвергаются с сообщением
+void testGraph6Loaders() {
+    struct Case {
+        string extension;
+        string content;
+        int vertices;       // < 0 — файл должен быть отвергнут
+        int edges;
+    };
+    vector<Case> cases = {
+        {"g6", "Bw", 3, 3},
+        {"g6", ">>graph6<<Bw\r\n", 3, 3},
+        {"g6", "", -1, 0},
+        {"g6", "D", -1, 0},                 // 5 вершин, нужно 2 байта данных
+        {"g6", "D?", -1, 0},
+        {"g6", string("B\x01", 2), -1, 0},
+        {"g6", "B w", -1, 0},
+        {"s6", ":Fa@x^", 7, 4},
+        {"s6", ":Fa@x^\n", 7, 4},
+        {"s6", "", -1, 0},
+        {"s6", ":", -1, 0},
+        {"s6", "Bw", -1, 0},                // без ':'
+        {"s6", ";Fa@x^", -1, 0},
+        {"s6", string(":Fa\x01x^", 6), -1, 0},
+        {"s6", ":Fa@ x^", -1, 0},
+    };
+    for (const Case& item : cases) {
+        Graph graph;
+        string error;
+        bool loaded = loadText(item.extension, item.content, graph, error);
+        string where = " (" + item.extension + " \"" + item.content + "\")";
+        if (item.vertices < 0) {
+            check(!loaded && !error.empty(), "загрузчик принял неверный файл" + where);
+        } else {
+            check(loaded, "загрузчик отверг файл: " + error + where);
+            check(graph.getVertexCount() == item.vertices && graph.getEdgeCount() == item.edges,
+                  "загрузчик: неверный граф" + where);
+        }
+    }
+}
+
+// Снимок с испорченными данными отвергается при проверке суммы
+void testSnapshotChecksum() {
+    Graph graph;
+    graph.generateRandom(50, 0.2, 7);
+    string filename = "tests_snapshot.csr";
+    check(saveGraphSnapshot(filename, graph), "снимок: не записан");
+    CsrGraph view;
+    check(loadGraphSnapshot(filename, view, true), "снимок: исправный файл отвергнут");
+    view = CsrGraph();
+    {
+        fstream file(filename, ios::binary | ios::in | ios::out);
+        file.seekg(0, ios::end);
+        streamoff size = file.tellg();
+        file.seekp(size - 8);
+        file.put('\x7f');
+    }
+    string error;
+    check(!loadGraphSnapshot(filename, view, true, &error) && !error.empty(),
+          "снимок: испорченные данные приняты при проверке суммы");
+    remove(filename.c_str());
+}
+
+int main() {
+    testContinuousQueryReordered();
+    testStaleTargetIndex();
+    testGraph6Loaders();
+    testSnapshotChecksum();
+    if (failures == 0) cout << "OK" << endl;
+    return failures == 0 ? 0 : 1;
+}